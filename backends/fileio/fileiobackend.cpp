@@ -3,11 +3,13 @@
 setBackendType(FileIoBackend)
 
     FileIoBackend::FileIoBackend(bool useSSL, const std::string& url, const std::string& name)
-    : HttplibBackend(useSSL, url, name) {
+    : HttplibBackend(useSSL, url, name), linkPrefix(predictBaseUrl()), urlPattern(linkPrefix, "a-zA-Z0-9") {
   capabilities.maxSize = 100 * 1024 * 1024;
   capabilities.preserveName.reset(new bool(false));
   capabilities.minRetention = 1ll * 24 * 60 * 60 * 1000;
   capabilities.maxRetention = 365ll * 24 * 60 * 60 * 1000;
+  // The start page of file.io is a web app behind a proxy, so only the connection is checked
+  probeMode = ProbeMode::Connect;
 }
 
 bool FileIoBackend::staticFileCheck(BackendRequirements requirements, const File& file) const {
@@ -27,8 +29,6 @@ void FileIoBackend::uploadFile(BackendRequirements requirements,
                                const File& file,
                                std::function<void(std::string)> successCallback,
                                std::function<void(std::string)> errorCallback) {
-  httplib::MultipartFormDataItems items = {{"file", file.getContent(), file.getName(), file.getMimetype()}};
-
   std::string endpoint;
 
   long long retentionPeriod = determineRetention(requirements);
@@ -38,8 +38,8 @@ void FileIoBackend::uploadFile(BackendRequirements requirements,
   endpoint.append("d");
 
   try {
-    std::string response = postForm(items, {}, endpoint);
-    std::vector<std::string> urls = findValidUrls(response, "https://file.io/[a-zA-Z0-9]+");
+    std::string response = postForm(file, "file", {}, {}, endpoint);
+    std::vector<std::string> urls = findValidUrls(response, urlPattern);
     if(!urls.empty()) {
       successCallback(urls.front());
     } else {
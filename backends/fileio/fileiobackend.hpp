@@ -6,7 +6,6 @@
 #include <backend.hpp>
 #include <httplibbackend.hpp>
 #include <logger.hpp>
-#include <regex>
 #include <string>
 #include <variant>
 
@@ -21,6 +20,9 @@ class FileIoBackend: public HttplibBackend {
   static std::vector<Backend*> loadBackends();
 
  private:
+  // The links start with the base url, which is the mock server in tests
+  std::string linkPrefix;
+  UrlPattern urlPattern;
   [[nodiscard]] std::string predictUrl(BackendRequirements requirements, const File& file) const override;
 };
 
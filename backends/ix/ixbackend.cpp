@@ -8,6 +8,9 @@ setBackendType(IxBackend)
   capabilities.preserveName.reset(new bool(false));
   capabilities.minRetention = 365ll * 24 * 60 * 60 * 1000;
   capabilities.maxRetention = 365ll * 24 * 60 * 60 * 1000;
+  // ix.io answers HEAD requests to its usage page
+  probeMode = ProbeMode::Head;
+  probePath = "/";
 }
 
 bool IxBackend::staticFileCheck(BackendRequirements requirements, const File& file) const {
@@ -27,10 +30,8 @@ void IxBackend::uploadFile(BackendRequirements requirements,
                            const File& file,
                            std::function<void(std::string)> successCallback,
                            std::function<void(std::string)> errorCallback) {
-  httplib::MultipartFormDataItems items = {{"f:1", file.getContent(), file.getName(), file.getMimetype()}};
-
   try {
-    std::string response = postForm(items);
+    std::string response = postForm(file, "f:1");
     std::vector<std::string> urls = findValidUrls(response);
     if(!urls.empty()) {
       successCallback(urls.front());
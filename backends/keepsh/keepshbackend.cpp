@@ -9,6 +9,9 @@ setBackendType(KeepShBackend)
   capabilities.minRetention = 1ll * 24 * 60 * 60 * 1000;
   capabilities.maxRetention = 14ll * 24 * 60 * 60 * 1000;
   capabilities.maxDownloads.reset(new long(LONG_MAX));
+  // keep.sh answers HEAD requests to its start page
+  probeMode = ProbeMode::Head;
+  probePath = "/";
 }
 
 void KeepShBackend::uploadFile(BackendRequirements requirements,
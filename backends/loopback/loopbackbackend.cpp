@@ -0,0 +1,79 @@
+#include "loopbackbackend.hpp"
+
+#include <climits>
+
+setBackendType(LoopbackBackend)
+
+    LoopbackBackend::LoopbackBackend(bool useSSL, const std::string& url, const std::string& name)
+    : HttplibBackend(useSSL, url, name) {
+  // The mock server accepts everything
+  capabilities.maxSize = 1ll << 40;
+  capabilities.minRetention = 0ll;
+  capabilities.maxRetention = LLONG_MAX;
+  capabilities.maxDownloads.reset(new long(LONG_MAX));
+  capabilities.chunkedUploads = true;
+  // The mock server answers HEAD requests to / without delay
+  probeMode = ProbeMode::Head;
+  probePath = "/";
+}
+
+bool LoopbackBackend::staticFileCheck(BackendRequirements requirements, const File& file) const {
+  if(!checkFile(file)) {
+    return false;
+  }
+
+  const std::string& predictedUrl = predictUrl(requirements, file);
+  if(!checkUrl(requirements, predictedUrl)) {
+    return false;
+  }
+
+  return true;
+}
+
+void LoopbackBackend::uploadFile(BackendRequirements requirements,
+                                 const File& file,
+                                 std::function<void(std::string)> successCallback,
+                                 std::function<void(std::string)> errorCallback) {
+  try {
+    std::string response = postForm(file, "file");
+    std::vector<std::string> urls = findValidUrls(response);
+    if(!urls.empty()) {
+      successCallback(urls.front());
+    } else {
+      std::string message = "Response did not contain any urls";
+      errorCallback(message);
+    }
+  } catch(std::runtime_error& error) {
+    errorCallback(error.what());
+  }
+}
+
+std::vector<Backend*> LoopbackBackend::loadBackends() {
+  std::vector<Backend*> backends;
+
+  std::optional<std::pair<bool, std::string>> loopbackUrl = getLoopbackUrl();
+  if(!loopbackUrl) {
+    return backends;
+  }
+
+  try {
+    Backend* backend = new LoopbackBackend(loopbackUrl->first, loopbackUrl->second, "loopback");
+    backends.push_back(backend);
+  } catch(std::invalid_argument& e) {
+    logger.log(Logger::Info) << "Failed to load loopback:" << e.what() << "\n";
+  }
+
+  return backends;
+}
+
+std::string LoopbackBackend::predictUrl(BackendRequirements requirements, const File& file) const {
+  // The mock server answers with /f/<id>/<filename>
+  std::string fullUrl = predictBaseUrl();
+  fullUrl.append("f/");
+  for(int i = 0; i < 8; i++) {
+    fullUrl.push_back(randomCharacter);
+  }
+  fullUrl.append("/");
+  fullUrl.append(file.getName());
+  return fullUrl;
+}
@@ -0,0 +1,27 @@
+#ifndef LOOPBACK_BACKEND_HPP
+#define LOOPBACK_BACKEND_HPP
+
+#include <httplib.h>
+
+#include <backend.hpp>
+#include <httplibbackend.hpp>
+#include <logger.hpp>
+#include <string>
+
+// Uploads to a local mock server. Only loaded, if UPLOAD_LOOPBACK_URL is set to the address of the mock server, like
+// 127.0.0.1:8080 or https://127.0.0.1:8443.
+class LoopbackBackend: public HttplibBackend {
+ public:
+  explicit LoopbackBackend(bool useSSL, const std::string& url, const std::string& name = "loopback");
+  [[nodiscard]] bool staticFileCheck(BackendRequirements requirements, const File& file) const override;
+  void uploadFile(BackendRequirements requiredFeatures,
+                  const File& file,
+                  std::function<void(std::string)> successCallback,
+                  std::function<void(std::string)> errorCallback) override;
+  static std::vector<Backend*> loadBackends();
+
+ private:
+  [[nodiscard]] std::string predictUrl(BackendRequirements requirements, const File& file) const override;
+};
+
+#endif
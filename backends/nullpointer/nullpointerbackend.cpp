@@ -8,6 +8,9 @@ setBackendType(NullPointerBackend)
   capabilities.preserveName.reset(new bool(false));
   capabilities.minRetention = 30ll * 24 * 60 * 60 * 1000;
   capabilities.maxRetention = 365ll * 24 * 60 * 60 * 1000;
+  // 0x0.st answers HEAD requests to its short usage page
+  probeMode = ProbeMode::Head;
+  probePath = "/";
 }
 
 bool NullPointerBackend::staticFileCheck(BackendRequirements requirements, const File& file) const {
@@ -49,10 +52,8 @@ void NullPointerBackend::uploadFile(BackendRequirements requirements,
                                     const File& file,
                                     std::function<void(std::string)> successCallback,
                                     std::function<void(std::string)> errorCallback) {
-  httplib::MultipartFormDataItems items = {{"file", file.getContent(), file.getName(), file.getMimetype()}};
-
   try {
-    std::string response = postForm(items);
+    std::string response = postForm(file, "file");
     std::vector<std::string> urls = findValidUrls(response);
     if(!urls.empty()) {
       successCallback(urls.front());
@@ -69,7 +70,7 @@ long long NullPointerBackend::calculateRetentionPeriod(const File& f) const {
   long long min_age = capabilities.minRetention;
   long long max_age = capabilities.maxRetention;
   size_t max_size = capabilities.maxSize;
-  size_t file_size = f.getContent().size();
+  size_t file_size = f.getSize();
   long long retention = min_age + (-max_age + min_age) * static_cast<long long>(std::pow((file_size / max_size - 1), 3));
   if(retention < min_age) {
     return min_age;
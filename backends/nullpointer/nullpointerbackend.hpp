@@ -6,7 +6,6 @@
 #include <backend.hpp>
 #include <httplibbackend.hpp>
 #include <logger.hpp>
-#include <regex>
 #include <string>
 #include <variant>
 
@@ -8,18 +8,20 @@ setBackendType(OshiBackend)
   capabilities.minRetention = 1ll * 60 * 1000;
   capabilities.maxRetention = 90ll * 24 * 60 * 60 * 1000;
   capabilities.maxDownloads.reset(new long(1));
+  // oshi.at only answers requests slowly, so only the connection is checked
+  probeMode = ProbeMode::Connect;
 }
 
 void OshiBackend::uploadFile(BackendRequirements requirements,
                              const File& file,
                              std::function<void(std::string)> successCallback,
                              std::function<void(std::string)> errorCallback) {
-  std::shared_ptr<httplib::MultipartFormDataItems> items = generateFormData(requirements, file);
+  std::shared_ptr<httplib::MultipartFormDataItems> fields = generateFormData(requirements, file);
 
   try {
-    std::string response = postForm(*items);
+    std::string response = postForm(file, "f", *fields);
     std::vector<std::string> urls = findValidUrls(response);
-    logger.log(Logger::Topic::Debug) << "Received " << urls.size() << " urls." << '\n';
+    UPLOAD_LOG(Logger::Topic::Debug) << "Received " << urls.size() << " urls." << '\n';
     if(urls.size() == 2) {
       std::string managementUrl = urls[0];
       std::string downloadUrl = urls[1];
@@ -35,8 +37,6 @@ void OshiBackend::uploadFile(BackendRequirements requirements,
 
 std::shared_ptr<httplib::MultipartFormDataItems> OshiBackend::generateFormData(const BackendRequirements& requirements, const File& file) {
   std::shared_ptr<httplib::MultipartFormDataItems> formData(new httplib::MultipartFormDataItems());
-  formData->push_back({"f", file.getContent(), file.getName(), file.getMimetype()});
-
   long long retentionPeriod = determineRetention(requirements);
   int retentionMinutes = static_cast<int>(retentionPeriod / (60ll * 1000ll));
   formData->push_back({"expire", std::to_string(retentionMinutes)});
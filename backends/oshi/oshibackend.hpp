@@ -5,7 +5,6 @@
 
 #include <httplibbackend.hpp>
 #include <logger.hpp>
-#include <regex>
 #include <string>
 #include <variant>
 
@@ -22,6 +21,7 @@ class OshiBackend: public HttplibBackend {
   static std::vector<Backend*> loadBackends();
 
  private:
+  // Generate the form fields for the upload, except the file itself
   std::shared_ptr<httplib::MultipartFormDataItems> generateFormData(const BackendRequirements& requirements, const File& file);
   // Determine the url type. If the url of the returned url type is not compatible with requirements, no other urlType is as well.
   [[nodiscard]] UrlType getUrlType(BackendRequirements requirements, const File& file) const;
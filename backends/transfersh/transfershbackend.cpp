@@ -9,6 +9,11 @@ setBackendType(TransferShBackend)
   capabilities.minRetention = 1ll * 24 * 60 * 60 * 1000;
   capabilities.maxRetention = 14ll * 24 * 60 * 60 * 1000;
   capabilities.maxDownloads.reset(new long(LONG_MAX));
+  // transfer.sh documents uploads from pipes with curl --upload-file -, which sends chunked requests
+  capabilities.chunkedUploads = true;
+  // transfer.sh answers HEAD requests to its start page
+  probeMode = ProbeMode::Head;
+  probePath = "/";
 }
 
 void TransferShBackend::uploadFile(BackendRequirements requirements,
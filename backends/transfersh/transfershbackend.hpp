@@ -5,7 +5,6 @@
 
 #include <httplibbackend.hpp>
 #include <logger.hpp>
-#include <regex>
 #include <string>
 #include <variant>
 
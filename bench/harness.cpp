@@ -0,0 +1,61 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <cxxopts.hpp>
+#include <iostream>
+#include <sstream>
+
+Harness::Harness(int argc, char** argv) {
+  cxxopts::Options options("bench", "Benchmark the hot paths of upload");
+  // clang-format off
+  options.add_options()
+  ("filter", "Only run benchmarks whose name contains TEXT.", cxxopts::value<std::string>()->default_value(""), "TEXT")
+  ("min-time", "Run every benchmark for at least SECONDS.", cxxopts::value<double>()->default_value("0.5"), "SECONDS")
+  ;
+  // clang-format on
+  try {
+    auto result = options.parse(argc, argv);
+    filter = result["filter"].as<std::string>();
+    minimumTime = std::chrono::duration<double>(result["min-time"].as<double>());
+  } catch(const cxxopts::OptionException& e) {
+    std::cerr << e.what() << std::endl;
+    exit(64);
+  }
+}
+
+bool Harness::isSelected(const std::string& name) const {
+  return name.find(filter) != std::string::npos;
+}
+
+void Harness::run(const std::string& name, size_t bytes, const std::function<void()>& function) const {
+  if(!isSelected(name)) {
+    return;
+  }
+  // The first run warms up caches and connections
+  function();
+
+  size_t iterations = 1;
+  std::chrono::duration<double> elapsed;
+  while(true) {
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; i++) {
+      function();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    if(elapsed >= minimumTime) {
+      break;
+    }
+    // Aim a bit above the minimum time, but do not grow too fast for noisy first measurements
+    double factor = elapsed.count() > 0 ? minimumTime.count() / elapsed.count() * 1.2 : 10;
+    iterations = std::max(iterations + 1, static_cast<size_t>(static_cast<double>(iterations) * std::clamp(factor, 1.0, 10.0)));
+  }
+
+  double seconds = elapsed.count() / static_cast<double>(iterations);
+  std::stringstream json;
+  json << "{\"benchmark\":\"" << name << "\",\"iterations\":" << iterations << ",\"nanosecondsPerIteration\":" << seconds * 1e9;
+  if(bytes != 0) {
+    json << ",\"bytesPerSecond\":" << static_cast<double>(bytes) / seconds;
+  }
+  json << "}";
+  std::cout << json.str() << std::endl;
+}
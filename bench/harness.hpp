@@ -0,0 +1,29 @@
+#ifndef HARNESS_HPP
+#define HARNESS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Runs benchmarks and prints one JSON object per benchmark to stdout, so the results can be compared between versions.
+class Harness {
+  std::chrono::duration<double> minimumTime;
+  // Only benchmarks whose name contains the filter are run
+  std::string filter;
+
+ public:
+  // Options are --filter=TEXT and --min-time=SECONDS
+  Harness(int argc, char** argv);
+  [[nodiscard]] bool isSelected(const std::string& name) const;
+  // Run function repeatedly, until the runs took at least the minimum time. bytes is the amount of data one run processes or 0
+  void run(const std::string& name, size_t bytes, const std::function<void()>& function) const;
+};
+
+// Prevent the compiler from removing the computation of value
+template<typename T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#endif
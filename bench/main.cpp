@@ -0,0 +1,256 @@
+#include <httplib.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <httplibbackend.hpp>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "file.hpp"
+#include "harness.hpp"
+#include "loader.hpp"
+#include "mockserver.hpp"
+#include "settings.hpp"
+#include "uploader.hpp"
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Exposes the helpers of the backends, that are used for every upload
+struct BackendInternals: public HttplibBackend {
+  using HttplibBackend::defaultUrlPattern;
+  using HttplibBackend::findValidUrls;
+  using HttplibBackend::writeBody;
+};
+
+struct Size {
+  std::string name;
+  size_t bytes;
+};
+
+const std::vector<Size> fileSizes = {{"0B", 0}, {"4KiB", 4 * 1024}, {"1MiB", 1024 * 1024}, {"64MiB", 64 * 1024 * 1024}};
+
+std::string generateContent(size_t size, bool compressible) {
+  static std::mt19937 generator(42);
+  std::string content(size, '\0');
+  if(compressible) {
+    static constexpr std::string_view words = "upload files to the internet and print the url where you can download them ";
+    for(size_t i = 0; i < size; i++) {
+      content[i] = words[(i + i / 977) % words.size()];
+    }
+  } else {
+    std::uniform_int_distribution<int> distribution(0, 255);
+    for(char& character : content) {
+      character = static_cast<char>(distribution(generator));
+    }
+  }
+  return content;
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& content) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+// Creates a tree of text and binary files with a total size of about 16 MiB
+void createTree(const std::filesystem::path& root) {
+  for(int directory = 0; directory < 8; directory++) {
+    for(int file = 0; file < 32; file++) {
+      size_t size = (file % 4 == 0) ? 256 * 1024 : 4 * 1024 * static_cast<size_t>(file + 1);
+      bool compressible = file % 3 != 0;
+      std::filesystem::path path = root / ("directory" + std::to_string(directory)) / ("file" + std::to_string(file) + (compressible ? ".txt" : ".bin"));
+      writeFile(path, generateContent(size, compressible));
+    }
+  }
+}
+
+// Settings are only created from arguments
+Settings createSettings(std::vector<std::string> arguments) {
+  arguments.insert(arguments.begin(), "upload");
+  std::vector<char*> argv;
+  for(std::string& argument : arguments) {
+    argv.push_back(argument.data());
+  }
+  return Settings(static_cast<int>(argv.size()), argv.data());
+}
+
+size_t readAll(const File& file) {
+  size_t bytes = 0;
+  file.readChunks([&bytes](const char* data, size_t length) {
+    doNotOptimize(data[length / 2]);
+    bytes += length;
+    return true;
+  });
+  return bytes;
+}
+
+void benchmarkFiles(const Harness& harness, const std::filesystem::path& directory) {
+  for(const Size& size : fileSizes) {
+    std::filesystem::path path = directory / ("file-" + size.name);
+    writeFile(path, generateContent(size.bytes, false));
+    for(bool memoryMap : {true, false}) {
+      std::string method = memoryMap ? "mmap" : "stream";
+      harness.run("file/construct/" + size.name + "/" + method, 0, [&]() {
+        File file(path, File::defaultBufferSize, memoryMap);
+        doNotOptimize(file.getSize());
+      });
+      harness.run("file/read/" + size.name + "/" + method, size.bytes, [&]() {
+        File file(path, File::defaultBufferSize, memoryMap);
+        doNotOptimize(readAll(file));
+      });
+    }
+  }
+
+  // The mimetype is cached per file, so new files are created to measure the detection. program and Makefile are detected by content
+  std::vector<std::pair<std::string, std::string>> files;
+  for(const char* name : {"notes.txt", "photo.JPG", "archive.tar.gz", "index.html", "data.h5", "video.webm"}) {
+    files.emplace_back(name, std::string());
+  }
+  files.emplace_back("program", std::string("\177ELF\2\1\1\0", 8) + generateContent(1024, false));
+  files.emplace_back("Makefile", "all:\n\tmake -C src\n");
+  harness.run("file/mimetype", 0, [&]() {
+    for(const auto& [name, content] : files) {
+      File file(name, content);
+      doNotOptimize(file.getMimetype());
+    }
+  });
+}
+
+void benchmarkResponses(const Harness& harness) {
+  std::string page;
+  for(int i = 0; i < 200; i++) {
+    page.append(R"(<div class="entry"><a href="https://example.org/page/)" + std::to_string(i) + R"(">Entry )" + std::to_string(i) +
+                "</a><p>Some text without links, that fills the page like the real pages do.</p></div>\n");
+  }
+
+  struct Response {
+    std::string name;
+    std::string body;
+    UrlPattern pattern;
+  };
+  std::vector<Response> responses = {
+      {"nullpointer", "https://0x0.st/oAbC.txt\n", BackendInternals::defaultUrlPattern},
+      {"oshi", "MANAGE: https://oshi.at/a/1b2c3d4e5f6a7b8c9d0e\nDL: https://oshi.at/AbCdEf/notes.txt\n", BackendInternals::defaultUrlPattern},
+      {"transfersh", "https://transfer.sh/AbCdEf/notes.txt", BackendInternals::defaultUrlPattern},
+      {"fileio",
+       R"({"success":true,"status":200,"id":"d3a1c0f0-0000-11ec-8a5e-9d3f1a0e1b2c","key":"AbCdEfGh","name":"notes.txt","link":"https://file.io/AbCdEfGh","private":false,"expires":"2021-08-21T12:00:00.000Z","downloads":0,"maxDownloads":1,"autoDelete":true,"size":1024,"mimeType":"text/plain"})",
+       UrlPattern("https://file.io/", "a-zA-Z0-9")},
+      {"htmlpage", page, BackendInternals::defaultUrlPattern},
+  };
+  for(const Response& response : responses) {
+    harness.run("urls/" + response.name, response.body.size(), [&]() {
+      doNotOptimize(BackendInternals::findValidUrls(response.body, response.pattern));
+    });
+  }
+}
+
+void benchmarkMultipart(const Harness& harness) {
+  std::string head =
+      "--upload-boundary-0123456789abcdefghijklmn\r\nContent-Disposition: form-data; name=\"file\"; filename=\"notes.txt\"\r\n"
+      "Content-Type: text/plain\r\n\r\n";
+  std::string tail = "\r\n--upload-boundary-0123456789abcdefghijklmn--\r\n";
+  for(const Size& size : fileSizes) {
+    File file("notes.txt", generateContent(size.bytes, true));
+    harness.run("multipart/" + size.name, head.size() + size.bytes + tail.size(), [&]() {
+      size_t written = 0;
+      httplib::DataSink sink;
+      sink.write = [&written](const char*, size_t length) {
+        written += length;
+        return true;
+      };
+      sink.is_writable = []() {
+        return true;
+      };
+      BackendInternals::writeBody(head, file, tail, 0, sink);
+      doNotOptimize(written);
+    });
+  }
+}
+
+void benchmarkArchives(const Harness& harness, const std::filesystem::path& directory) {
+  std::filesystem::path tree = directory / "tree";
+  createTree(tree);
+  size_t treeSize = 0;
+  for(const auto& entry : std::filesystem::recursive_directory_iterator(tree)) {
+    if(entry.is_regular_file()) {
+      treeSize += entry.file_size();
+    }
+  }
+
+  for(const char* type : {"zip", "tar", "tar.gz", "tar.zst"}) {
+    if(!harness.isSelected(std::string("archive/") + type)) {
+      continue;
+    }
+    Settings settings = createSettings({"-a", "--archive-type", type, "-n", "tree", tree.string()});
+    harness.run(std::string("archive/") + type, treeSize, [&]() {
+      Loader loader(settings);
+      std::shared_ptr<File> archive = loader.getNextFile();
+      doNotOptimize(readAll(*archive));
+    });
+  }
+}
+
+void benchmarkUploads(const Harness& harness, const std::filesystem::path& directory) {
+  if(!harness.isSelected("upload/")) {
+    return;
+  }
+  MockServer server(MockServer::Options{});
+  int port = server.bind();
+  std::jthread serverThread([&server]() {
+    server.listen();
+  });
+
+  std::string address = "127.0.0.1:" + std::to_string(port);
+  setenv("UPLOAD_LOOPBACK_URL", address.c_str(), 1);
+  std::filesystem::path placeholder = directory / "placeholder";
+  writeFile(placeholder, "");
+  Settings settings = createSettings({"--http", "-b", "loopback", "--cache-ttl", "0", placeholder.string()});
+  Uploader uploader(settings);
+
+  for(const Size& size : fileSizes) {
+    File file("upload.bin", generateContent(size.bytes, false));
+    harness.run("upload/loopback/" + size.name, size.bytes, [&]() {
+      doNotOptimize(uploader.uploadFile(file).url);
+    });
+  }
+
+  // The other backends send their requests to the mock server too, which answers like their services
+  for(const std::string backend : {"THE NULL POINTER", "oshi", "file.io", "ix", "transfer.sh"}) {
+    Settings backendSettings = createSettings({"--http", "-b", backend, "--cache-ttl", "0", placeholder.string()});
+    Uploader backendUploader(backendSettings);
+    File file("upload.bin", generateContent(4 * 1024, false));
+    harness.run("upload/" + backend + "/4KiB", file.getSize(), [&]() {
+      doNotOptimize(backendUploader.uploadFile(file).url);
+    });
+  }
+  server.stop();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Harness harness(argc, argv);
+
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "upload-bench";
+#ifdef __unix__
+  directory += "-" + std::to_string(getpid());
+#endif
+  std::filesystem::create_directories(directory);
+
+  benchmarkFiles(harness, directory);
+  benchmarkResponses(harness);
+  benchmarkMultipart(harness);
+  benchmarkArchives(harness, directory);
+  benchmarkUploads(harness, directory);
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
@@ -42,6 +42,7 @@
 
             buildInputs = [
               openssl
+              zstd
             ];
 
             patchPhase = ''
@@ -34,6 +34,9 @@ struct BackendCapabilities {
   // If set, the file can be deleted after a maximum of this many downloads
   // It is assumed, that there is always an option to not delete files
   std::shared_ptr<long> maxDownloads;
+  // True if the backend accepts uploads with chunked transfer encoding. Files without known size are generated completely before they
+  // are uploaded to other backends, because their exact size is needed
+  bool chunkedUploads = false;
 
   bool meetsRequirements(BackendRequirements requirements) const;
 };
@@ -0,0 +1,90 @@
+#ifndef CLIENT_POOL_HPP
+#define CLIENT_POOL_HPP
+
+#include <httplib.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// A pool of http clients for one host. The clients keep their connections alive, so later requests can reuse the connection and
+// do not have to negotiate tcp and tls again. Every concurrent request gets its own client.
+class ClientPool {
+ public:
+  using ClientFactory = std::function<std::unique_ptr<httplib::Client>()>;
+
+  // A client borrowed from the pool. It is returned to the pool, when the lease is destroyed.
+  class Lease {
+    ClientPool* pool;
+    std::unique_ptr<httplib::Client> client;
+
+   public:
+    Lease(ClientPool* pool, std::unique_ptr<httplib::Client> client);
+    Lease(const Lease&) = delete;
+    Lease(Lease&& other) noexcept = default;
+    ~Lease();
+    httplib::Client* operator->() const;
+    httplib::Client& operator*() const;
+  };
+
+ private:
+  ClientFactory createClient;
+  size_t maxIdleClients;
+  // Lock the mutex, when accessing idleClients
+  std::mutex mutex;
+  std::vector<std::unique_ptr<httplib::Client>> idleClients;
+
+ public:
+  explicit ClientPool(ClientFactory createClient, size_t maxIdleClients = defaultMaxIdleClients);
+  ClientPool(const ClientPool&) = delete;
+  // Get the most recently used idle client or create a new one
+  Lease acquire();
+
+  static constexpr size_t defaultMaxIdleClients = 8;
+
+ private:
+  void release(std::unique_ptr<httplib::Client> client);
+};
+
+inline ClientPool::Lease::Lease(ClientPool* pool, std::unique_ptr<httplib::Client> client): pool(pool), client(std::move(client)) {}
+
+inline ClientPool::Lease::~Lease() {
+  if(client != nullptr) {
+    pool->release(std::move(client));
+  }
+}
+
+inline httplib::Client* ClientPool::Lease::operator->() const {
+  return client.get();
+}
+
+inline httplib::Client& ClientPool::Lease::operator*() const {
+  return *client;
+}
+
+inline ClientPool::ClientPool(ClientFactory createClient, size_t maxIdleClients)
+    : createClient(std::move(createClient)), maxIdleClients(maxIdleClients) {}
+
+inline ClientPool::Lease ClientPool::acquire() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if(!idleClients.empty()) {
+      std::unique_ptr<httplib::Client> client = std::move(idleClients.back());
+      idleClients.pop_back();
+      return Lease(this, std::move(client));
+    }
+  }
+  return Lease(this, createClient());
+}
+
+inline void ClientPool::release(std::unique_ptr<httplib::Client> client) {
+  std::unique_lock<std::mutex> lock(mutex);
+  // Surplus clients are destroyed, which closes their connections
+  if(idleClients.size() < maxIdleClients) {
+    idleClients.push_back(std::move(client));
+  }
+}
+
+#endif
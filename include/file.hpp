@@ -3,18 +3,87 @@
 
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
 
+// A named piece of content. The content of files on disk is not loaded into memory, but read in chunks when it is needed.
 class File {
+ public:
+  // Gets called with each chunk of content. Return false to stop reading.
+  using ChunkCallback = std::function<bool(const char* data, size_t length)>;
+  // The default maximum size of a chunk
+  static constexpr size_t defaultBufferSize = 64 * 1024;
+
+  // Provides the content of a file
+  class Source {
+   public:
+    virtual ~Source() = default;
+    [[nodiscard]] virtual size_t getSize() const = 0;
+    // If the size is not known before the content is read, getSize only returns an upper bound
+    [[nodiscard]] virtual bool isSizeKnown() const;
+    // Get the exact size. Sources that only know an upper bound generate their content and discard it to measure it.
+    // Throws std::runtime_error, if reading failed
+    virtual size_t getExactSize();
+    // Read up to length bytes starting at offset into buffer. Returns the number of bytes read.
+    // Throws std::runtime_error, if reading failed
+    virtual size_t read(size_t offset, char* buffer, size_t length) = 0;
+    // Get a view of the complete content. The view stays valid as long as the source exists.
+    // Throws std::runtime_error, if reading failed
+    virtual std::string_view getContent() = 0;
+    // Read the content starting at offset in chunks of at most chunkSize bytes. Returns false, if the callback stopped reading.
+    // By default the chunks are read into a buffer. Sources that already have their content in memory pass it directly.
+    // Throws std::runtime_error, if reading failed
+    virtual bool readChunks(const ChunkCallback& callback, size_t offset, size_t chunkSize);
+  };
+
+ private:
+  // The mimetype is detected on the first request
+  struct DetectedMimetype {
+    std::once_flag detected;
+    std::string mimetype;
+  };
+
   std::string name;
-  std::string content;
+  // Copies of a file share their source and their mimetype
+  std::shared_ptr<Source> source;
+  size_t bufferSize;
+  std::shared_ptr<DetectedMimetype> detectedMimetype = std::make_shared<DetectedMimetype>();
 
  public:
-  explicit File(const std::filesystem::path& path);
+  // If memoryMap is set, regular files are mapped into memory instead of being read into buffers
+  explicit File(const std::filesystem::path& path, size_t bufferSize = defaultBufferSize, bool memoryMap = true);
   File(std::string name, std::string content);
-  [[nodiscard]] std::string getName() const;
-  [[nodiscard]] std::string getContent() const;
-  [[nodiscard]] std::string getMimetype() const;
+  File(std::string name, std::shared_ptr<Source> source, size_t bufferSize = defaultBufferSize);
+  // Wrap the content of file in source. The name, the buffer size and the mimetype of file are kept.
+  File(const File& file, std::shared_ptr<Source> source);
+  [[nodiscard]] const std::string& getName() const;
+  [[nodiscard]] size_t getSize() const;
+  [[nodiscard]] bool isSizeKnown() const;
+  // Get the exact size. If the size is not known, the content is generated once more to count it, so prefer getSize for estimates.
+  // Throws std::runtime_error, if reading failed
+  [[nodiscard]] size_t getExactSize() const;
+  [[nodiscard]] size_t getBufferSize() const;
+  // Read up to length bytes starting at offset into buffer. Returns the number of bytes read.
+  // Throws std::runtime_error, if reading failed
+  size_t read(size_t offset, char* buffer, size_t length) const;
+  // Read the content starting at offset in chunks of at most bufferSize bytes. Only one chunk is kept in memory at a time.
+  // Returns false, if the callback stopped reading. Throws std::runtime_error, if reading failed
+  bool readChunks(const ChunkCallback& callback, size_t offset = 0) const;
+  // Get a view of the complete content. The view is valid as long as this file or a copy of it exists.
+  // Files on disk are read into memory on the first call, so you should prefer readChunks for big files. Archives do not provide their
+  // complete content and throw std::runtime_error.
+  [[nodiscard]] std::string_view getContent() const;
+  [[nodiscard]] std::span<const std::byte> getBytes() const;
+  // Get the mimetype from the extension. If the extension is unknown, the type is detected from the first bytes of the content.
+  // The mimetype is only detected once and shared with all copies of this file.
+  [[nodiscard]] const std::string& getMimetype() const;
+
+ private:
+  [[nodiscard]] std::string detectMimetype() const;
 };
 
 #endif
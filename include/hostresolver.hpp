@@ -0,0 +1,302 @@
+#ifndef HOST_RESOLVER_HPP
+#define HOST_RESOLVER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __unix__
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+// Resolves the hostnames of backends in the background, so all backends are resolved in parallel. Before the first connection to a host,
+// connections to its IPv6 and IPv4 addresses are raced like happy eyeballs (RFC 8305). The address that connected first is used by all
+// clients for that host, so a broken address family does not stall every connection and clients do not resolve the host again.
+class HostResolver {
+  struct Address {
+    int family;
+    sockaddr_storage storage;
+    socklen_t length;
+  };
+
+  struct Host {
+    std::string hostname;
+    std::shared_future<std::vector<Address>> addresses;
+    // The address that connected first. Not set, if no address connected. Only valid after the first connection to the host
+    std::shared_future<std::optional<Address>> address;
+  };
+
+  // Lock the mutex, when accessing hosts
+  std::mutex mutex;
+  std::map<std::string, Host> hosts;
+
+ public:
+  // The next address is tried after this delay, if the previous attempts did not connect yet
+  static constexpr std::chrono::milliseconds connectionAttemptDelay{250};
+  static constexpr std::chrono::milliseconds connectionTimeout{5000};
+
+  // The resolver that is shared by all backends
+  static HostResolver& getInstance();
+  // Start resolving host in the background. host can contain a port
+  void prefetch(const std::string& host, bool useSSL);
+  // Get the hostname of host mapped to the numeric address that clients should connect to, like httplib::Client::set_hostname_addr_map
+  // expects it. Blocks until the host is resolved and the connections are raced, but at most for timeout. Returns an empty map, if no
+  // address connected or the race did not finish in time. Then the race continues in the background for later clients
+  std::map<std::string, std::string> getAddressMap(const std::string& host, bool useSSL, std::chrono::milliseconds timeout = connectionTimeout);
+  // Open a tcp connection to the address that won the race for host. Returns the socket or -1, if it did not connect within timeout
+  int connect(const std::string& host, bool useSSL, std::chrono::milliseconds timeout = connectionTimeout);
+  // Split host into the hostname and the port
+  static std::pair<std::string, std::string> splitHost(const std::string& host, bool useSSL);
+
+ private:
+  // Get the entry for host and start resolving it, if it is new. Lock the mutex, before calling this
+  Host& getHost(const std::string& host, bool useSSL);
+  // Wait at most timeout for the address that won the race for host and the hostname of host
+  std::pair<std::string, std::optional<Address>> getAddress(const std::string& host, bool useSSL, std::chrono::milliseconds timeout);
+  static std::vector<Address> resolve(const std::string& hostname, const std::string& port);
+  // Connect to the addresses and return the first address that connected
+  static std::optional<Address> raceAddresses(std::vector<Address> addresses);
+  static std::string toNumericHost(const Address& address);
+};
+
+inline HostResolver& HostResolver::getInstance() {
+  // Never destroyed, so exiting does not wait for pending resolutions
+  static auto* resolver = new HostResolver();
+  return *resolver;
+}
+
+inline void HostResolver::prefetch(const std::string& host, bool useSSL) {
+  std::unique_lock<std::mutex> lock(mutex);
+  getHost(host, useSSL);
+}
+
+inline std::map<std::string, std::string> HostResolver::getAddressMap(const std::string& host,
+                                                                      bool useSSL,
+                                                                      std::chrono::milliseconds timeout) {
+  auto [hostname, address] = getAddress(host, useSSL, timeout);
+  std::string numericHost = address ? toNumericHost(*address) : std::string();
+  if(numericHost.empty()) {
+    return {};
+  }
+  return {{hostname, numericHost}};
+}
+
+inline int HostResolver::connect(const std::string& host, bool useSSL, std::chrono::milliseconds timeout) {
+#ifdef __unix__
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  std::optional<Address> address = getAddress(host, useSSL, timeout).second;
+  if(!address) {
+    return -1;
+  }
+  int fd = socket(address->family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(fd < 0) {
+    return -1;
+  }
+  if(::connect(fd, reinterpret_cast<const sockaddr*>(&address->storage), address->length) != 0) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    pollfd attempt{fd, POLLOUT, 0};
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if(errno != EINPROGRESS || poll(&attempt, 1, static_cast<int>(std::max<long long>(remaining, 0))) <= 0 ||
+       getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+      close(fd);
+      return -1;
+    }
+  }
+  // The caller gets a blocking socket like from a normal connect
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+  return fd;
+#else
+  return -1;
+#endif
+}
+
+inline std::pair<std::string, std::optional<HostResolver::Address>> HostResolver::getAddress(const std::string& host,
+                                                                                            bool useSSL,
+                                                                                            std::chrono::milliseconds timeout) {
+  std::string hostname;
+  std::shared_future<std::optional<Address>> address;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    Host& resolvedHost = getHost(host, useSSL);
+    if(!resolvedHost.address.valid()) {
+      resolvedHost.address = std::async(std::launch::async, [addresses = resolvedHost.addresses]() {
+                               return raceAddresses(addresses.get());
+                             }).share();
+    }
+    hostname = resolvedHost.hostname;
+    address = resolvedHost.address;
+  }
+  if(address.wait_for(timeout) != std::future_status::ready) {
+    return {hostname, std::nullopt};
+  }
+  return {hostname, address.get()};
+}
+
+inline HostResolver::Host& HostResolver::getHost(const std::string& host, bool useSSL) {
+  std::string key = (useSSL ? "https://" : "http://") + host;
+  auto resolvedHost = hosts.find(key);
+  if(resolvedHost == hosts.end()) {
+    auto [hostname, port] = splitHost(host, useSSL);
+    Host newHost;
+    newHost.hostname = hostname;
+    newHost.addresses = std::async(std::launch::async, &HostResolver::resolve, hostname, port).share();
+    resolvedHost = hosts.emplace(key, std::move(newHost)).first;
+  }
+  return resolvedHost->second;
+}
+
+inline std::pair<std::string, std::string> HostResolver::splitHost(const std::string& host, bool useSSL) {
+  std::string defaultPort = useSSL ? "443" : "80";
+  // IPv6 addresses are enclosed in brackets, because they contain colons
+  if(host.starts_with('[')) {
+    size_t end = host.find(']');
+    if(end != std::string::npos) {
+      std::string port = end + 1 < host.size() && host[end + 1] == ':' ? host.substr(end + 2) : defaultPort;
+      return {host.substr(1, end - 1), port};
+    }
+  }
+  size_t colon = host.find(':');
+  if(colon != std::string::npos && host.find(':', colon + 1) == std::string::npos) {
+    return {host.substr(0, colon), host.substr(colon + 1)};
+  }
+  return {host, defaultPort};
+}
+
+inline std::vector<HostResolver::Address> HostResolver::resolve(const std::string& hostname, const std::string& port) {
+  std::vector<Address> addresses;
+#ifdef __unix__
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if(getaddrinfo(hostname.c_str(), port.c_str(), &hints, &result) != 0) {
+    return addresses;
+  }
+  for(const addrinfo* info = result; info != nullptr; info = info->ai_next) {
+    Address address{info->ai_family, {}, info->ai_addrlen};
+    std::copy_n(reinterpret_cast<const char*>(info->ai_addr), info->ai_addrlen, reinterpret_cast<char*>(&address.storage));
+    addresses.push_back(address);
+  }
+  freeaddrinfo(result);
+#endif
+  return addresses;
+}
+
+inline std::string HostResolver::toNumericHost(const Address& address) {
+#ifdef __unix__
+  char host[NI_MAXHOST];
+  if(getnameinfo(reinterpret_cast<const sockaddr*>(&address.storage), address.length, host, sizeof(host), nullptr, 0, NI_NUMERICHOST) != 0) {
+    return {};
+  }
+  return host;
+#else
+  return {};
+#endif
+}
+
+inline std::optional<HostResolver::Address> HostResolver::raceAddresses(std::vector<Address> addresses) {
+#ifdef __unix__
+  // A single address does not need a race
+  if(addresses.size() <= 1) {
+    return addresses.empty() ? std::nullopt : std::optional<Address>(addresses.front());
+  }
+  // Alternate between the address families, starting with the family the system prefers
+  std::vector<Address> preferred;
+  std::vector<Address> other;
+  for(const Address& address : addresses) {
+    if(preferred.empty() || address.family == preferred.front().family) {
+      preferred.push_back(address);
+    } else {
+      other.push_back(address);
+    }
+  }
+  addresses.clear();
+  for(size_t i = 0; i < std::max(preferred.size(), other.size()); i++) {
+    if(i < preferred.size()) {
+      addresses.push_back(preferred[i]);
+    }
+    if(i < other.size()) {
+      addresses.push_back(other[i]);
+    }
+  }
+
+  std::vector<pollfd> attempts;
+  // The index of the address of each attempt
+  std::vector<size_t> attemptAddresses;
+  std::optional<size_t> winner;
+  size_t next = 0;
+  auto now = std::chrono::steady_clock::now();
+  auto deadline = now + connectionTimeout;
+  auto nextStart = now;
+  while(!winner && now < deadline && (next < addresses.size() || !attempts.empty())) {
+    if(next < addresses.size() && (now >= nextStart || attempts.empty())) {
+      size_t index = next++;
+      const Address& address = addresses[index];
+      int fd = socket(address.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if(fd < 0) {
+        continue;
+      }
+      if(::connect(fd, reinterpret_cast<const sockaddr*>(&address.storage), address.length) == 0) {
+        winner = index;
+        close(fd);
+      } else if(errno == EINPROGRESS) {
+        attempts.push_back({fd, POLLOUT, 0});
+        attemptAddresses.push_back(index);
+        nextStart = now + connectionAttemptDelay;
+      } else {
+        close(fd);
+      }
+      continue;
+    }
+
+    auto wakeup = next < addresses.size() ? std::min(nextStart, deadline) : deadline;
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(wakeup - now).count();
+    int ready = poll(attempts.data(), attempts.size(), static_cast<int>(std::max<long long>(timeout, 0)));
+    now = std::chrono::steady_clock::now();
+    if(ready <= 0) {
+      continue;
+    }
+    for(size_t i = 0; i < attempts.size();) {
+      if(attempts[i].revents == 0) {
+        i++;
+        continue;
+      }
+      int error = 0;
+      socklen_t length = sizeof(error);
+      if(getsockopt(attempts[i].fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0) {
+        error = errno;
+      }
+      close(attempts[i].fd);
+      if(error == 0 && !winner) {
+        winner = attemptAddresses[i];
+      } else if(error != 0) {
+        // A failed attempt starts the next attempt immediately
+        nextStart = now;
+      }
+      attempts.erase(attempts.begin() + static_cast<std::ptrdiff_t>(i));
+      attemptAddresses.erase(attemptAddresses.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+  }
+  for(const pollfd& attempt : attempts) {
+    close(attempt.fd);
+  }
+  return winner ? std::optional<Address>(addresses[*winner]) : std::nullopt;
+#else
+  return std::nullopt;
+#endif
+}
+
+#endif
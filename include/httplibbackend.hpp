@@ -4,7 +4,15 @@
 #include <httplib.h>
 
 #include <backend.hpp>
+#include <clientpool.hpp>
+#include <hostresolver.hpp>
+#include <cstdlib>
 #include <logger.hpp>
+#include <optional>
+#include <random>
+#include <tuple>
+#include <string_view>
+#include <urlpattern.hpp>
 #include <utility>
 
 class HttplibBackend: public Backend {
@@ -25,23 +33,68 @@ class HttplibBackend: public Backend {
 
  protected:
   static constexpr auto uploadUserAgent = "upload/0.0";
+  // If this is set to the address of a mock server, every backend sends its requests there instead of to its service
+  static constexpr auto loopbackUrlVariable = "UPLOAD_LOOPBACK_URL";
   // TODO improve expression
-  static constexpr auto defaultUrlRegex = "http[-\\]_.~!*'();:@&=+$,/?%#[A-z0-9]+";
+  static constexpr UrlPattern defaultUrlPattern{"http", "-]_.~!*'();:@&=+$,/?%#[A-z0-9"};
   static constexpr auto randomCharacter = ' ';
+  // How a backend is checked. Set the probe the service supports in the constructor. Every probe except Connect leaves its connection
+  // open for the first upload
+  enum class ProbeMode {
+    // Open a connection and close it again without a request. Tls connections are checked with a handshake. Use this for backends that
+    // answer requests slowly or do not answer requests without an upload
+    Connect,
+    // Request the headers of probePath. Costs one round trip after the connection is established
+    Head,
+    // Request probePath. Use this for backends that do not answer HEAD requests and have a small resource
+    Get,
+    // Post nothing to probePath. Use this for backends that only answer uploads
+    Post
+  };
   std::string name;
   std::string url;
   bool useSSL;
   BackendCapabilities capabilities;
-  httplib::Client* client;
-
-  [[nodiscard]] bool isReachable(std::string& errorMessage);
+  // Clients with open connections to url. The client used for checking the backend is reused for the uploads.
+  ClientPool clients;
+  ProbeMode probeMode = ProbeMode::Head;
+  std::string probePath = "/";
+
+  // Get whether the mock server from loopbackUrlVariable uses https and its address without the scheme. Not set, if the variable is empty
+  [[nodiscard]] static std::optional<std::pair<bool, std::string>> getLoopbackUrl();
+  [[nodiscard]] bool isReachable(httplib::Client& client, std::string& errorMessage);
+  // Check that a connection to url can be opened within timeoutMillis
+  [[nodiscard]] bool isConnectable(int timeoutMillis, std::string& errorMessage);
   [[nodiscard]] bool checkFile(const File& f) const;
-  void initializeClient(const std::string& userAgent);
+  [[nodiscard]] std::unique_ptr<httplib::Client> createClient(const std::string& userAgent) const;
+  // Get a client that connects to the address that won the connection race for url, without resolving url again. Waits at most
+  // raceTimeout for the race and lets the client resolve url itself, if it did not finish
+  ClientPool::Lease acquireClient(std::chrono::milliseconds raceTimeout = HostResolver::connectionTimeout);
   std::string getErrorMessage(httplib::Error error);
   [[nodiscard]] static bool checkMimetype(const File& file, const std::vector<std::string>& blacklist);
-  std::string postForm(const httplib::MultipartFormDataItems& form, const httplib::Headers& headers = {}, const std::string& endpoint = "");
+  // Post a multipart form with file in the field fileField and the additional fields. The file content is streamed.
+  std::string postForm(const File& file,
+                       const std::string& fileField,
+                       const httplib::MultipartFormDataItems& fields = {},
+                       const httplib::Headers& headers = {},
+                       const std::string& endpoint = "");
+  // Put file to /filename. The file content is streamed.
   std::string putFile(const File& file, const httplib::Headers& headers = {});
-  static std::vector<std::string> findValidUrls(const std::string& input, const std::string& urlRegex = defaultUrlRegex);
+  // Check the response of an upload and return its body.
+  std::string checkResult(const httplib::Result& result);
+  // Write head, the content of file and tail to sink, starting at offset. If the size of file is not known, offset has to be 0. The file content is read in chunks, while it is written.
+  // Returns false, if the sink stopped accepting data. Throws std::runtime_error, if reading the file failed
+  static bool writeBody(std::string_view head, const File& file, std::string_view tail, size_t offset, httplib::DataSink& sink);
+  // Send a request with the body generated by writeBody.
+  httplib::Result sendBody(const std::string& method,
+                           const std::string& path,
+                           const httplib::Headers& headers,
+                           std::string_view head,
+                           const File& file,
+                           std::string_view tail,
+                           const std::string& contentType);
+  static std::string generateBoundary();
+  static std::vector<std::string> findValidUrls(std::string_view input, const UrlPattern& urlPattern = defaultUrlPattern);
   [[nodiscard]] long long determineRetention(const BackendRequirements& requirements) const;
   [[nodiscard]] long determineMaxDownloads(const BackendRequirements& requirements) const;
   [[nodiscard]] [[maybe_unused]] virtual std::string predictBaseUrl() const;
@@ -52,8 +105,14 @@ class HttplibBackend: public Backend {
 };
 
 inline HttplibBackend::HttplibBackend(bool useSSL, std::string url, std::string name, const std::string& userAgent)
-    : name(std::move(name)), url(std::move(url)), useSSL(useSSL), client(nullptr) {
-  if(useSSL) {
+    : name(std::move(name)), url(std::move(url)), useSSL(useSSL), clients([this, userAgent]() {
+        return createClient(userAgent);
+      }) {
+  // The response parsers of the services can be tested against the mock server
+  if(std::optional<std::pair<bool, std::string>> loopbackUrl = getLoopbackUrl()) {
+    std::tie(this->useSSL, this->url) = *loopbackUrl;
+  }
+  if(this->useSSL) {
     capabilities.http = false;
     capabilities.https = true;
   } else {
@@ -64,11 +123,27 @@ inline HttplibBackend::HttplibBackend(bool useSSL, std::string url, std::string
   capabilities.minRetention = 0ll;
   capabilities.maxRetention = 0ll;
 
-  initializeClient(userAgent);
+  // All backends are constructed at startup, so their hosts are resolved in parallel
+  HostResolver::getInstance().prefetch(this->url, this->useSSL);
+  // Create the first client now, so unsupported protocols are detected on construction
+  clients.acquire();
 }
 
-inline HttplibBackend::~HttplibBackend() {
-  delete client;
+inline HttplibBackend::~HttplibBackend() = default;
+
+inline std::optional<std::pair<bool, std::string>> HttplibBackend::getLoopbackUrl() {
+  const char* variable = std::getenv(loopbackUrlVariable);
+  if(variable == nullptr || *variable == '\0') {
+    return std::nullopt;
+  }
+  std::string loopbackUrl = variable;
+  if(loopbackUrl.starts_with("https://")) {
+    return std::pair<bool, std::string>(true, loopbackUrl.substr(8));
+  }
+  if(loopbackUrl.starts_with("http://")) {
+    return std::pair<bool, std::string>(false, loopbackUrl.substr(7));
+  }
+  return std::pair<bool, std::string>(false, loopbackUrl);
 }
 
 inline std::string HttplibBackend::getName() const {
@@ -82,7 +157,7 @@ inline bool HttplibBackend::staticFileCheck(BackendRequirements requirements, co
 
 inline bool HttplibBackend::staticSettingsCheck(BackendRequirements requirements) const {
   if(!capabilities.meetsRequirements(requirements)) {
-    logger.log(Logger::Topic::Debug) << "Not all requiredFeatures are supported\n";
+    UPLOAD_LOG(Logger::Topic::Debug) << "Not all requiredFeatures are supported\n";
     return false;
   }
   return true;
@@ -93,12 +168,28 @@ inline void HttplibBackend::dynamicSettingsCheck(BackendRequirements requirement
                                                  std::function<void(std::string)> errorCallback,
                                                  int timeoutMillis) {
   std::string errorMessage;
-  client->set_connection_timeout(0, timeoutMillis * 1000);
-  client->set_read_timeout(0, timeoutMillis * 1000);
-  client->set_write_timeout(0, timeoutMillis * 1000);
+  if(probeMode == ProbeMode::Connect) {
+    if(isConnectable(timeoutMillis, errorMessage)) {
+      successCallback();
+    } else {
+      errorCallback(errorMessage);
+    }
+    return;
+  }
+
+  // The check has to finish within timeoutMillis, so the connection race gets half of it and the probe gets the rest
+  auto start = std::chrono::steady_clock::now();
+  ClientPool::Lease client = acquireClient(std::chrono::milliseconds(timeoutMillis / 2));
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  auto remainingMicros = std::max<long long>(timeoutMillis * 1000ll - elapsed.count(), 1000);
+  client->set_connection_timeout(0, remainingMicros);
+  client->set_read_timeout(0, remainingMicros);
+  client->set_write_timeout(0, remainingMicros);
 
-  bool reachable = isReachable(errorMessage);
+  // The connection is kept alive and reused by the first upload
+  bool reachable = isReachable(*client, errorMessage);
 
+  client->set_connection_timeout(CPPHTTPLIB_CONNECTION_TIMEOUT_SECOND, CPPHTTPLIB_CONNECTION_TIMEOUT_USECOND);
   client->set_read_timeout(CPPHTTPLIB_READ_TIMEOUT_SECOND, CPPHTTPLIB_READ_TIMEOUT_USECOND);
   client->set_write_timeout(CPPHTTPLIB_WRITE_TIMEOUT_SECOND, CPPHTTPLIB_WRITE_TIMEOUT_USECOND);
   if(reachable) {
@@ -108,9 +199,22 @@ inline void HttplibBackend::dynamicSettingsCheck(BackendRequirements requirement
   }
 }
 
-inline bool HttplibBackend::isReachable(std::string& errorMessage) {
-  if(auto result = client->Post("/")) {
-    logger.log(Logger::Topic::Debug) << "Received response from " << name << " (" << result->status << "): " << result->body << '\n';
+inline bool HttplibBackend::isReachable(httplib::Client& client, std::string& errorMessage) {
+  auto probe = [this, &client]() {
+    switch(probeMode) {
+      case ProbeMode::Get:
+        return client.Get(probePath.c_str());
+      case ProbeMode::Post:
+        return client.Post(probePath.c_str());
+      case ProbeMode::Head:
+      default:
+        return client.Head(probePath.c_str());
+    }
+  };
+  // Every response counts, because the probe only checks that the backend answers
+  if(auto result = probe()) {
+    UPLOAD_LOG(Logger::Topic::Debug) << "Received response from " << name << " (" << result->status << ") with " << result->body.size()
+                                     << " bytes." << '\n';
     return true;
   } else {
     errorMessage = getErrorMessage(result.error());
@@ -118,9 +222,51 @@ inline bool HttplibBackend::isReachable(std::string& errorMessage) {
   }
 }
 
+inline bool HttplibBackend::isConnectable(int timeoutMillis, std::string& errorMessage) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+  int fd = HostResolver::getInstance().connect(url, useSSL, std::chrono::milliseconds(timeoutMillis));
+  if(fd < 0) {
+    errorMessage = getErrorMessage(httplib::Connection);
+    return false;
+  }
+  bool connected = true;
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+  if(useSSL) {
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+    remaining = std::max<long long>(remaining, 1000);
+    timeval timeout{static_cast<time_t>(remaining / 1000000), static_cast<suseconds_t>(remaining % 1000000)};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // The context of the clients has the certificates, so the handshake is the same as for requests
+    SSL* ssl = SSL_new(clients.acquire()->ssl_context());
+    std::string hostname = HostResolver::splitHost(url, useSSL).first;
+    connected = ssl != nullptr && SSL_set_fd(ssl, fd) == 1 && SSL_set_tlsext_host_name(ssl, hostname.c_str()) == 1 && SSL_connect(ssl) == 1;
+    if(connected) {
+      SSL_shutdown(ssl);
+    } else {
+      errorMessage = getErrorMessage(httplib::SSLConnection);
+    }
+    SSL_free(ssl);
+  }
+#endif
+  close(fd);
+  return connected;
+}
+
 inline bool HttplibBackend::checkFile(const File& file) const {
-  if(file.getContent().size() > capabilities.maxSize) {
-    logger.log(Logger::Topic::Info) << name << " has a size limit of 512 MiB per file." << '\n';
+  size_t size = file.getSize();
+  // Archives only know an upper bound of their size, so they are generated and counted to check, whether they are really too big
+  if(size > capabilities.maxSize && !file.isSizeKnown()) {
+    try {
+      size = file.getExactSize();
+    } catch(const std::runtime_error& error) {
+      logger.log(Logger::Topic::Info) << "Failed to get the size of " << file.getName() << ". " << error.what() << '\n';
+      return false;
+    }
+  }
+  if(size > capabilities.maxSize) {
+    logger.log(Logger::Topic::Info) << name << " has a size limit of " << capabilities.maxSize / (1024 * 1024) << " MiB per file." << '\n';
     return false;
   }
   return true;
@@ -138,7 +284,7 @@ inline void loadIntegratedCerts(SSL_CTX* ctx) {
   BIO* cbio = BIO_new_mem_buf(cacertpem, sizeof(cacertpem));
   X509_STORE* cts = SSL_CTX_get_cert_store(ctx);
   if(!cts || !cbio) {
-    logger.log(Logger::Debug) << "Loading integrated certificates failed.";
+    UPLOAD_LOG(Logger::Debug) << "Loading integrated certificates failed.";
     return;
   }
   X509_INFO* itmp;
@@ -147,7 +293,7 @@ inline void loadIntegratedCerts(SSL_CTX* ctx) {
 
   if(!inf) {
     BIO_free(cbio);  // cleanup
-    logger.log(Logger::Debug) << "Loading integrated certificates failed.";
+    UPLOAD_LOG(Logger::Debug) << "Loading integrated certificates failed.";
     return;
   }
   // iterate over all entries from the pem file, add them to the x509_store one by one
@@ -168,35 +314,41 @@ inline void loadIntegratedCerts(SSL_CTX* ctx) {
 #endif
 #endif
 
-inline void HttplibBackend::initializeClient(const std::string& userAgent) {
-  if(client == nullptr) {
-    std::string httpUrl;
-    if(useSSL) {
+inline std::unique_ptr<httplib::Client> HttplibBackend::createClient(const std::string& userAgent) const {
+  std::string httpUrl;
+  if(useSSL) {
 #ifdef CPPHTTPLIB_OPENSSL_SUPPORT
-      logger.log(Logger::Topic::Debug) << "HTTPS is supported\n";
-      httpUrl = "https://";
+    UPLOAD_LOG(Logger::Topic::Debug) << "HTTPS is supported\n";
+    httpUrl = "https://";
 #else
-      logger.log(Logger::Topic::Debug) << "HTTPS is not supported\n";
-      throw std::invalid_argument("https is disabled");
+    UPLOAD_LOG(Logger::Topic::Debug) << "HTTPS is not supported\n";
+    throw std::invalid_argument("https is disabled");
 #endif
-    } else {
-      httpUrl = "http://";
-    }
-    httpUrl.append(url);
+  } else {
+    httpUrl = "http://";
+  }
+  httpUrl.append(url);
 
-    client = new httplib::Client(httpUrl.c_str());
+  auto client = std::make_unique<httplib::Client>(httpUrl.c_str());
 #ifdef INTEGRATED_CERTIFICATES
 #ifdef CPPHTTPLIB_OPENSSL_SUPPORT
-    if(useSSL) {
-      loadIntegratedCerts(client->ssl_context());
-    }
+  if(useSSL) {
+    loadIntegratedCerts(client->ssl_context());
+  }
 #else
 #error "You have activated integrated certificates, did not activate openssl support. Maybe try defining CPPHTTPLIB_OPENSSL_SUPPORT."
 #endif
 #endif
-    httplib::Headers headers = {{"Accept", "*/*"}, {"User-Agent", userAgent}};
-    client->set_default_headers(headers);
-  }
+  httplib::Headers headers = {{"Accept", "*/*"}, {"User-Agent", userAgent}};
+  client->set_default_headers(headers);
+  client->set_keep_alive(true);
+  return client;
+}
+
+inline ClientPool::Lease HttplibBackend::acquireClient(std::chrono::milliseconds raceTimeout) {
+  ClientPool::Lease client = clients.acquire();
+  client->set_hostname_addr_map(HostResolver::getInstance().getAddressMap(url, useSSL, raceTimeout));
+  return client;
 }
 
 inline std::string HttplibBackend::getErrorMessage(httplib::Error error) {
@@ -244,32 +396,95 @@ inline bool HttplibBackend::checkMimetype(const File& file, const std::vector<st
   return true;
 }
 
-inline std::string HttplibBackend::postForm(const httplib::MultipartFormDataItems& form,
+inline std::string HttplibBackend::postForm(const File& file,
+                                            const std::string& fileField,
+                                            const httplib::MultipartFormDataItems& fields,
                                             const httplib::Headers& headers,
                                             const std::string& endpoint) {
-  std::string urlExtension = "/";
-  urlExtension.append(endpoint);
-  if(auto result = client->Post(urlExtension.c_str(), headers, form)) {
-    logger.log(Logger::Topic::Debug) << "Received response from " << name << " (" << result->status << "): " << result->body << '\n';
-    if(result->status != 200) {
-      std::stringstream message;
-      message << "Request failed, responsecode " << httplib::detail::status_message(result->status) << "(" << result->status << ").";
-      throw(std::runtime_error(message.str()));
+  std::string boundary = generateBoundary();
+  std::string contentType = "multipart/form-data; boundary=" + boundary;
+
+  // Only the parts of the body before and after the file content are generated
+  std::string head;
+  head.append("--").append(boundary).append("\r\n");
+  head.append("Content-Disposition: form-data; name=\"").append(fileField).append("\"; filename=\"").append(file.getName()).append("\"\r\n");
+  head.append("Content-Type: ").append(file.getMimetype()).append("\r\n\r\n");
+
+  std::string tail = "\r\n";
+  for(const httplib::MultipartFormData& field : fields) {
+    tail.append("--").append(boundary).append("\r\n");
+    tail.append("Content-Disposition: form-data; name=\"").append(field.name).append("\"");
+    if(!field.filename.empty()) {
+      tail.append("; filename=\"").append(field.filename).append("\"");
     }
-
-    return result->body;
-  } else {
-    std::stringstream message;
-    message << "Request failed: " << getErrorMessage(result.error()) << ".";
-    throw(std::runtime_error(message.str()));
+    tail.append("\r\n");
+    if(!field.content_type.empty()) {
+      tail.append("Content-Type: ").append(field.content_type).append("\r\n");
+    }
+    tail.append("\r\n").append(field.content).append("\r\n");
   }
+  tail.append("--").append(boundary).append("--\r\n");
+
+  std::string urlExtension = "/";
+  urlExtension.append(endpoint);
+  return checkResult(sendBody("POST", urlExtension, headers, head, file, tail, contentType));
 }
 
 inline std::string HttplibBackend::putFile(const File& file, const httplib::Headers& headers) {
   std::string path = "/";
   path.append(file.getName());
-  if(auto result = client->Put(path.c_str(), headers, file.getContent().data(), file.getContent().size(), file.getMimetype().c_str())) {
-    logger.log(Logger::Topic::Debug) << "Received response from " << name << " (" << result->status << "): " << result->body << '\n';
+
+  return checkResult(sendBody("PUT", path, headers, {}, file, {}, file.getMimetype()));
+}
+
+inline httplib::Result HttplibBackend::sendBody(const std::string& method,
+                                                const std::string& path,
+                                                const httplib::Headers& headers,
+                                                std::string_view head,
+                                                const File& file,
+                                                std::string_view tail,
+                                                const std::string& contentType) {
+  // Exceptions are not thrown through cpp-httplib, but rethrown after the request was canceled
+  std::string readError;
+  httplib::ContentProvider contentProvider = [&](size_t offset, size_t, httplib::DataSink& sink) {
+    try {
+      return writeBody(head, file, tail, offset, sink);
+    } catch(const std::runtime_error& error) {
+      readError = error.what();
+      return false;
+    }
+  };
+
+  ClientPool::Lease client = acquireClient();
+  auto send = [&]() {
+    // Backends without chunked uploads need the exact size, so files without known size are generated once to count their bytes and
+    // once more while they are sent
+    if(file.isSizeKnown() || !capabilities.chunkedUploads) {
+      size_t length = head.size() + file.getExactSize() + tail.size();
+      return method == "PUT" ? client->Put(path.c_str(), headers, length, contentProvider, contentType.c_str())
+                             : client->Post(path.c_str(), headers, length, contentProvider, contentType.c_str());
+    }
+    // Otherwise files without known size are sent with chunked transfer encoding, while they are generated
+    httplib::ContentProviderWithoutLength chunkedContentProvider = [&contentProvider](size_t offset, httplib::DataSink& sink) {
+      if(!contentProvider(offset, 0, sink)) {
+        return false;
+      }
+      sink.done();
+      return true;
+    };
+    return method == "PUT" ? client->Put(path.c_str(), headers, chunkedContentProvider, contentType.c_str())
+                           : client->Post(path.c_str(), headers, chunkedContentProvider, contentType.c_str());
+  };
+  httplib::Result result = send();
+  if(!readError.empty()) {
+    throw std::runtime_error(readError);
+  }
+  return result;
+}
+
+inline std::string HttplibBackend::checkResult(const httplib::Result& result) {
+  if(result) {
+    UPLOAD_LOG(Logger::Topic::Debug) << "Received response from " << name << " (" << result->status << "): " << result->body << '\n';
     if(result->status != 200) {
       std::stringstream message;
       message << "Request failed, responsecode " << httplib::detail::status_message(result->status) << "(" << result->status << ").";
@@ -284,18 +499,54 @@ inline std::string HttplibBackend::putFile(const File& file, const httplib::Head
   }
 }
 
-inline std::vector<std::string> HttplibBackend::findValidUrls(const std::string& input, const std::string& urlRegex) {
-  std::regex urlExpression(urlRegex, std::regex::icase | std::regex::ECMAScript);
-  auto urlsBegin = std::sregex_iterator(input.begin(), input.end(), urlExpression);
-  auto urlsEnd = std::sregex_iterator();
+inline bool HttplibBackend::writeBody(std::string_view head,
+                                     const File& file,
+                                     std::string_view tail,
+                                     size_t offset,
+                                     httplib::DataSink& sink) {
+  if(offset < head.size()) {
+    sink.write(head.data() + offset, head.size() - offset);
+    offset = 0;
+  } else {
+    offset -= head.size();
+  }
+
+  // The content of files without known size can only be written from the start
+  if(!file.isSizeKnown() || offset < file.getSize()) {
+    bool finished = file.readChunks(
+        [&sink](const char* data, size_t length) {
+          sink.write(data, length);
+          return sink.is_writable();
+        },
+        offset);
+    if(!finished) {
+      return false;
+    }
+    offset = 0;
+  } else {
+    offset -= file.getSize();
+  }
+
+  if(offset < tail.size()) {
+    sink.write(tail.data() + offset, tail.size() - offset);
+  }
+  return true;
+}
+
+inline std::string HttplibBackend::generateBoundary() {
+  static constexpr char characters[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  static thread_local std::mt19937 generator(std::random_device{}());
+  std::uniform_int_distribution<size_t> distribution(0, sizeof(characters) - 2);
 
-  std::vector<std::string> resultsVector;
-  for(std::sregex_iterator i = urlsBegin; i != urlsEnd; ++i) {
-    std::smatch match = *i;
-    resultsVector.push_back(match.str());
+  std::string boundary = "--upload-boundary-";
+  for(int i = 0; i < 24; i++) {
+    boundary.push_back(characters[distribution(generator)]);
   }
+  return boundary;
+}
 
-  return resultsVector;
+inline std::vector<std::string> HttplibBackend::findValidUrls(std::string_view input, const UrlPattern& urlPattern) {
+  return urlPattern.findAll(input);
 }
 
 inline long long HttplibBackend::determineRetention(const BackendRequirements& requirements) const {
@@ -371,7 +622,7 @@ inline bool HttplibBackend::checkUrl(const BackendRequirements& requirements, si
 }
 
 inline std::string HttplibBackend::predictUrl(BackendRequirements, const File&) const {
-  logger.log(Logger::Debug) << "Called default predictUrl, this should not happen. You should check your backend implementation"
+  UPLOAD_LOG(Logger::Debug) << "Called default predictUrl, this should not happen. You should check your backend implementation"
                             << "\n";
   return std::string();
 }
@@ -1,11 +1,24 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <array>
+#include <cstddef>
 #include <fstream>
 #include <iostream>
-#include <map>
+#include <mutex>
 #include <string>
 
+// Set UPLOAD_DEBUG_LOGGING to 0 to remove all debug messages at compile time
+#ifndef UPLOAD_DEBUG_LOGGING
+#define UPLOAD_DEBUG_LOGGING 1
+#endif
+
+// Like logger.log(topic), but the arguments are not even evaluated, if the topic is disabled. Use this for all debug messages.
+#define UPLOAD_LOG(topic)                                                                                                              \
+  if(!logger.getTopicState(topic)) {                                                                                                   \
+  } else                                                                                                                               \
+    logger.log(topic)
+
 // TODO maybe rename to printer
 class Logger {
  public:
@@ -18,20 +31,58 @@ class Logger {
   // UploadFatal = file uploading failed, program might exit
   enum Topic { Fatal, Print, Info, Debug, Url, LoadFatal, UploadFatal };
 
+  // A message that is formatted into a buffer of the current thread and written to its stream at once, when the record is destroyed.
+  // Records of disabled topics do not format anything.
+  class Record {
+    Logger* logger;
+    std::ostream* stream;
+    // Where the message starts in the buffer. Records can be nested, if an argument logs something
+    size_t start;
+
+   public:
+    Record(Logger* logger, std::ostream* stream);
+    Record(const Record&) = delete;
+    ~Record();
+
+    template<typename T>
+    Record& operator<<(const T& value) {
+      if(stream != nullptr) {
+        logger->getBuffer() << value;
+      }
+      return *this;
+    }
+
+    // Manipulators like std::endl
+    Record& operator<<(std::ostream& (*manipulator)(std::ostream&));
+  };
+
  private:
-  std::map<Topic, std::ostream*> topicStream;
-  std::ostream* nullstream;
+  static constexpr size_t topicCount = UploadFatal + 1;
+  std::array<std::ostream*, topicCount> topicStream{};
+  // Lock the mutex, when writing to a stream
+  std::mutex streamMutex;
 
  public:
   Logger();
   Logger(Logger&) = delete;
-  ~Logger();
-  bool getTopicState(Topic topic);
+  // Topics without stream are disabled
+  [[nodiscard]] bool getTopicState(Topic topic) const {
+    return (UPLOAD_DEBUG_LOGGING || topic != Debug) && topicStream[topic] != nullptr;
+  }
+  // Set the streams, before logging from multiple threads
   void setTopicStream(Topic topic, std::ostream* stream);
   void setTopicStream(Topic topic, Topic stream);
   void log(Topic topic, const std::string& message);
-  std::ostream& log(Topic topic);
-  std::ostream& debug();
+  Record log(Topic topic) {
+    return {this, getTopicState(topic) ? topicStream[topic] : nullptr};
+  }
+  Record debug();
+
+ private:
+  // The buffer of the current thread
+  static std::ostream& getBuffer();
+  // Write the message in the buffer of the current thread after start to stream and remove it from the buffer
+  void write(std::ostream& stream, size_t start);
 };
 
 // Global logger object
@@ -0,0 +1,82 @@
+#ifndef URL_PATTERN_HPP
+#define URL_PATTERN_HPP
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds urls in responses. A pattern matches a prefix followed by one or more characters of a character class, like the regular
+// expression prefix[characters]+ with the icase flag. The pattern is built at compile time and matching is a single pass over the input,
+// so it does not have the construction and backtracking costs of std::regex.
+class UrlPattern {
+  std::string_view prefix;
+  std::array<bool, 256> characters{};
+
+ public:
+  // characterClass is the content of a bracket expression, like "a-zA-Z0-9". A - is a literal, if it is the first or last character.
+  constexpr UrlPattern(std::string_view prefix, std::string_view characterClass): prefix(prefix) {
+    for(size_t i = 0; i < characterClass.size(); i++) {
+      if(i + 2 < characterClass.size() && characterClass[i + 1] == '-') {
+        for(int character = index(characterClass[i]); character <= index(characterClass[i + 2]); character++) {
+          allow(static_cast<char>(character));
+        }
+        i += 2;
+      } else {
+        allow(characterClass[i]);
+      }
+    }
+  }
+
+  // Get all non-overlapping matches from left to right
+  [[nodiscard]] std::vector<std::string> findAll(std::string_view input) const {
+    std::vector<std::string> urls;
+    size_t position = 0;
+    while(position + prefix.size() < input.size()) {
+      if(!matchesPrefix(input, position)) {
+        position++;
+        continue;
+      }
+      size_t end = position + prefix.size();
+      while(end < input.size() && characters[index(input[end])]) {
+        end++;
+      }
+      if(end == position + prefix.size()) {
+        position++;
+        continue;
+      }
+      urls.emplace_back(input.substr(position, end - position));
+      position = end;
+    }
+    return urls;
+  }
+
+ private:
+  static constexpr unsigned char index(char character) {
+    return static_cast<unsigned char>(character);
+  }
+
+  static constexpr char toLower(char character) {
+    return character >= 'A' && character <= 'Z' ? static_cast<char>(character - 'A' + 'a') : character;
+  }
+
+  static constexpr char toUpper(char character) {
+    return character >= 'a' && character <= 'z' ? static_cast<char>(character - 'a' + 'A') : character;
+  }
+
+  constexpr void allow(char character) {
+    characters[index(toLower(character))] = true;
+    characters[index(toUpper(character))] = true;
+  }
+
+  [[nodiscard]] bool matchesPrefix(std::string_view input, size_t position) const {
+    for(size_t i = 0; i < prefix.size(); i++) {
+      if(toLower(input[position + i]) != toLower(prefix[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+#endif
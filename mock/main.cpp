@@ -0,0 +1,76 @@
+#include <csignal>
+#include <cxxopts.hpp>
+#include <iostream>
+
+#include "mockserver.hpp"
+
+namespace {
+
+MockServer* runningServer = nullptr;
+
+void stopServer(int) {
+  if(runningServer != nullptr) {
+    runningServer->stop();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  cxxopts::Options options("mockserver", "Answer uploads like the upload services, without storing anything");
+  // clang-format off
+  options.add_options()
+  ("h,help", "Displays this help screen")
+  ("host", "Listen on HOST.", cxxopts::value<std::string>()->default_value("127.0.0.1"), "HOST")
+  ("p,port", "Listen on PORT. 0 selects a free port.", cxxopts::value<int>()->default_value("0"), "PORT")
+  ("latency", "Delay every response by MS milliseconds.", cxxopts::value<long long>()->default_value("0"), "MS")
+  ("bandwidth", "Receive every upload with at most BYTES per second. 0 is unlimited.", cxxopts::value<size_t>()->default_value("0"), "BYTES")
+  ("failure-rate", "Answer uploads with 500 with probability P.", cxxopts::value<double>()->default_value("0"), "P")
+  ("certificate", "Serve https with the certificate in FILE.", cxxopts::value<std::string>(), "FILE")
+  ("private-key", "Serve https with the private key in FILE.", cxxopts::value<std::string>(), "FILE")
+  ;
+  // clang-format on
+
+  MockServer::Options serverOptions;
+  try {
+    auto result = options.parse(argc, argv);
+    if(result.count("help")) {
+      std::cout << options.help() << std::endl;
+      return 0;
+    }
+    serverOptions.host = result["host"].as<std::string>();
+    serverOptions.port = result["port"].as<int>();
+    serverOptions.latency = std::chrono::milliseconds(result["latency"].as<long long>());
+    serverOptions.bandwidth = result["bandwidth"].as<size_t>();
+    serverOptions.failureRate = result["failure-rate"].as<double>();
+    if(result.count("certificate") && result.count("private-key")) {
+      serverOptions.certificate = result["certificate"].as<std::string>();
+      serverOptions.privateKey = result["private-key"].as<std::string>();
+    }
+  } catch(const cxxopts::OptionException& e) {
+    std::cerr << e.what() << std::endl;
+    return 64;
+  }
+  if(serverOptions.failureRate < 0 || serverOptions.failureRate > 1) {
+    std::cerr << "The failure rate has to be between 0 and 1." << std::endl;
+    return 64;
+  }
+
+  try {
+    MockServer server(serverOptions);
+    int port = server.bind();
+    // The address is printed, so scripts can use a free port
+    std::cout << serverOptions.host << ":" << port << std::endl;
+
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    server.listen();
+    runningServer = nullptr;
+    std::cerr << "Received " << server.getUploads() << " uploads with " << server.getReceivedBytes() << " bytes." << std::endl;
+  } catch(const std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
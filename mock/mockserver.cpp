@@ -0,0 +1,183 @@
+#include "mockserver.hpp"
+
+#include <cctype>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+std::mt19937& getGenerator() {
+  static thread_local std::mt19937 generator(std::random_device{}());
+  return generator;
+}
+
+}  // namespace
+
+MockServer::MockServer(Options options): options(std::move(options)) {
+  if(!this->options.certificate.empty() && !this->options.privateKey.empty()) {
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    auto sslServer = std::make_unique<httplib::SSLServer>(this->options.certificate.c_str(), this->options.privateKey.c_str());
+    if(!sslServer->is_valid()) {
+      throw std::runtime_error("Failed to load the certificate or the private key.");
+    }
+    server = std::move(sslServer);
+    secure = true;
+#else
+    throw std::runtime_error("https is disabled");
+#endif
+  } else {
+    server = std::make_unique<httplib::Server>();
+  }
+  registerHandlers();
+}
+
+int MockServer::bind() {
+  if(options.port == 0) {
+    port = server->bind_to_any_port(options.host.c_str());
+  } else if(server->bind_to_port(options.host.c_str(), options.port)) {
+    port = options.port;
+  } else {
+    port = -1;
+  }
+  if(port < 0) {
+    throw std::runtime_error("Failed to bind to " + options.host + ".");
+  }
+  return port;
+}
+
+void MockServer::listen() {
+  server->listen_after_bind();
+}
+
+void MockServer::stop() {
+  server->stop();
+}
+
+size_t MockServer::getUploads() const {
+  return uploads;
+}
+
+size_t MockServer::getReceivedBytes() const {
+  return receivedBytes;
+}
+
+void MockServer::registerHandlers() {
+  // Checks only need an answer
+  server->Head("/", [this](const httplib::Request&, httplib::Response& response) {
+    respond(response);
+  });
+  server->Get("/", [this](const httplib::Request&, httplib::Response& response) {
+    if(respond(response)) {
+      response.set_content("upload mock server\n", "text/plain");
+    }
+  });
+
+  server->Post("/", [this](const httplib::Request& request, httplib::Response& response, const httplib::ContentReader& reader) {
+    auto [filename, fields] = receive(request, reader);
+    if(!respond(response)) {
+      return;
+    }
+    std::string url = createUrl(request, filename);
+    if(request.has_param("expires")) {
+      // file.io links only have an id
+      response.set_content(R"({"success":true,"status":200,"link":")" + createBaseUrl(request) + generateId() + R"("})", "application/json");
+    } else if(fields.contains("expire")) {
+      response.set_content("MANAGE: " + createUrl(request, "manage") + "\nDL: " + url + "\n", "text/plain");
+    } else {
+      response.set_content(url + "\n", "text/plain");
+    }
+  });
+
+  server->Put(R"(/([^/]+))", [this](const httplib::Request& request, httplib::Response& response, const httplib::ContentReader& reader) {
+    auto [filename, fields] = receive(request, reader);
+    if(respond(response)) {
+      response.set_content(createUrl(request, request.matches[1]) + "\n", "text/plain");
+    }
+  });
+}
+
+std::pair<std::string, httplib::Params> MockServer::receive(const httplib::Request& request, const httplib::ContentReader& reader) {
+  auto start = std::chrono::steady_clock::now();
+  size_t received = 0;
+  // Sleep until the bandwidth is not exceeded anymore
+  auto throttle = [this, &start, &received](size_t length) {
+    received += length;
+    receivedBytes += length;
+    if(options.bandwidth != 0) {
+      std::chrono::duration<double> minimumDuration(static_cast<double>(received) / static_cast<double>(options.bandwidth));
+      std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(minimumDuration));
+    }
+    return true;
+  };
+
+  std::string filename;
+  httplib::Params fields;
+  if(request.is_multipart_form_data()) {
+    std::string field;
+    bool isFile = false;
+    reader(
+        [&](const httplib::MultipartFormData& part) {
+          field = part.name;
+          isFile = !part.filename.empty();
+          if(isFile) {
+            filename = part.filename;
+          }
+          fields.emplace(field, "");
+          return true;
+        },
+        [&](const char* data, size_t length) {
+          if(!isFile) {
+            fields.find(field)->second.append(data, length);
+          }
+          return throttle(length);
+        });
+  } else {
+    reader([&](const char*, size_t length) {
+      return throttle(length);
+    });
+  }
+  uploads++;
+  return {filename.empty() ? "file" : filename, fields};
+}
+
+bool MockServer::respond(httplib::Response& response) {
+  std::this_thread::sleep_for(options.latency);
+  std::bernoulli_distribution failure(options.failureRate);
+  if(failure(getGenerator())) {
+    response.status = 500;
+    response.set_content("injected failure\n", "text/plain");
+    return false;
+  }
+  response.status = 200;
+  return true;
+}
+
+std::string MockServer::createBaseUrl(const httplib::Request& request) const {
+  std::string host = request.get_header_value("Host");
+  if(host.empty()) {
+    host = options.host + ":" + std::to_string(port);
+  }
+  return (secure ? "https://" : "http://") + host + "/";
+}
+
+std::string MockServer::createUrl(const httplib::Request& request, const std::string& filename) const {
+  // Characters that would end the url in the response are replaced
+  std::string urlFilename = filename;
+  for(char& character : urlFilename) {
+    if(!std::isalnum(static_cast<unsigned char>(character)) && character != '.' && character != '-' && character != '_') {
+      character = '_';
+    }
+  }
+  return createBaseUrl(request) + "f/" + generateId() + "/" + urlFilename;
+}
+
+std::string MockServer::generateId() {
+  static constexpr char characters[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  std::uniform_int_distribution<size_t> distribution(0, sizeof(characters) - 2);
+  std::string id;
+  for(int i = 0; i < 8; i++) {
+    id.push_back(characters[distribution(getGenerator())]);
+  }
+  return id;
+}
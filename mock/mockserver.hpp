@@ -0,0 +1,68 @@
+#ifndef MOCK_SERVER_HPP
+#define MOCK_SERVER_HPP
+
+#include <httplib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// A local stand-in for the upload services. It answers uploads like the real services, but discards the content. Latency, bandwidth
+// and failures can be injected, so the overhead of upload can be measured without the internet.
+//
+// POST / with a multipart form answers like 0x0.st and ix.io with the url. If the form has an expire field, it answers like oshi.at
+// with a management url and the url. If the request has an expires parameter, it answers like file.io with JSON.
+// PUT /<name> answers like transfer.sh and keep.sh with the url. If UPLOAD_LOOPBACK_URL points to the server, all backends send their
+// requests here, so their response parsers are exercised.
+class MockServer {
+ public:
+  struct Options {
+    std::string host = "127.0.0.1";
+    // 0 selects a free port
+    int port = 0;
+    // Added to every response
+    std::chrono::milliseconds latency{0};
+    // Bytes per second for receiving every upload. 0 does not limit the bandwidth
+    size_t bandwidth = 0;
+    // The probability of answering an upload with 500
+    double failureRate = 0;
+    // Serve https, if both are set
+    std::string certificate;
+    std::string privateKey;
+  };
+
+ private:
+  Options options;
+  std::unique_ptr<httplib::Server> server;
+  bool secure = false;
+  int port = 0;
+  std::atomic<size_t> uploads = 0;
+  std::atomic<size_t> receivedBytes = 0;
+
+ public:
+  // Throws std::runtime_error, if the certificate could not be loaded
+  explicit MockServer(Options options);
+  MockServer(const MockServer&) = delete;
+  // Bind to the port. Returns the port. Throws std::runtime_error, if binding failed
+  int bind();
+  // Serve requests, until stop is called. Call bind first
+  void listen();
+  void stop();
+  [[nodiscard]] size_t getUploads() const;
+  [[nodiscard]] size_t getReceivedBytes() const;
+
+ private:
+  void registerHandlers();
+  // Read the content of an upload with the configured bandwidth. Returns the filename and the fields of multipart forms
+  std::pair<std::string, httplib::Params> receive(const httplib::Request& request, const httplib::ContentReader& reader);
+  // Wait for the latency and decide, if the request fails. Returns false and sets the response, if it fails
+  bool respond(httplib::Response& response);
+  // The url of the server as the client addressed it, ending with a slash
+  [[nodiscard]] std::string createBaseUrl(const httplib::Request& request) const;
+  [[nodiscard]] std::string createUrl(const httplib::Request& request, const std::string& filename) const;
+  static std::string generateId();
+};
+
+#endif
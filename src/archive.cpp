@@ -0,0 +1,105 @@
+#include "archive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+ArchiveEntry ArchiveEntry::fromPath(std::string name, const std::filesystem::path& path) {
+  ArchiveEntry entry;
+  entry.name = std::move(name);
+  entry.path = path;
+  std::filesystem::file_status status = std::filesystem::status(path);
+  entry.directory = status.type() == std::filesystem::file_type::directory;
+  entry.size = entry.directory ? 0 : static_cast<size_t>(std::filesystem::file_size(path));
+  entry.permissions = status.permissions();
+  auto lastWriteTime = std::filesystem::last_write_time(path);
+  entry.modificationTime = std::chrono::system_clock::to_time_t(std::chrono::file_clock::to_sys(lastWriteTime));
+  return entry;
+}
+
+ArchiveSource::ArchiveSource(std::vector<ArchiveEntry> entries, size_t bufferSize, bool memoryMap)
+    : entries(std::move(entries)), bufferSize(bufferSize), memoryMap(memoryMap) {}
+
+bool ArchiveSource::isSizeKnown() const {
+  return false;
+}
+
+size_t ArchiveSource::getExactSize() {
+  if(isSizeKnown()) {
+    return getSize();
+  }
+  std::unique_lock<std::mutex> lock(exactSizeMutex);
+  if(!exactSize) {
+    size_t size = 0;
+    write([&size](const char*, size_t length) {
+      size += length;
+      return true;
+    });
+    exactSize = size;
+  }
+  return *exactSize;
+}
+
+size_t ArchiveSource::read(size_t offset, char* buffer, size_t length) {
+  size_t position = 0;
+  // The archive has to be generated until the requested range
+  readChunks(
+      [&](const char* data, size_t dataLength) {
+        size_t copied = std::min(dataLength, length - position);
+        std::copy_n(data, copied, buffer + position);
+        position += copied;
+        return position < length;
+      },
+      offset,
+      bufferSize);
+  return position;
+}
+
+std::string_view ArchiveSource::getContent() {
+  throw std::runtime_error("Archives are generated while they are read, so their complete content is not available.");
+}
+
+bool ArchiveSource::readChunks(const File::ChunkCallback& callback, size_t offset, size_t chunkSize) {
+  // The small writes of headers are collected, until there is a complete chunk
+  std::vector<char> buffer;
+  buffer.reserve(chunkSize);
+  bool finished = write([&](const char* data, size_t length) {
+    size_t skipped = std::min(offset, length);
+    offset -= skipped;
+    data += skipped;
+    length -= skipped;
+
+    while(length > 0) {
+      if(buffer.empty() && length >= chunkSize) {
+        if(!callback(data, chunkSize)) {
+          return false;
+        }
+        data += chunkSize;
+        length -= chunkSize;
+        continue;
+      }
+      size_t copied = std::min(chunkSize - buffer.size(), length);
+      buffer.insert(buffer.end(), data, data + copied);
+      data += copied;
+      length -= copied;
+      if(buffer.size() == chunkSize) {
+        if(!callback(buffer.data(), buffer.size())) {
+          return false;
+        }
+        buffer.clear();
+      }
+    }
+    return true;
+  });
+  if(!finished) {
+    return false;
+  }
+  if(!buffer.empty()) {
+    return callback(buffer.data(), buffer.size());
+  }
+  return true;
+}
+
+File ArchiveSource::openEntry(const ArchiveEntry& entry) const {
+  return File(entry.path, bufferSize, memoryMap);
+}
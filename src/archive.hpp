@@ -0,0 +1,63 @@
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file.hpp"
+
+// A file or directory that will be put into an archive
+struct ArchiveEntry {
+  // Path inside the archive
+  std::string name;
+  // Path in the filesystem. Only used for files
+  std::filesystem::path path;
+  bool directory;
+  size_t size;
+  std::time_t modificationTime;
+  std::filesystem::perms permissions;
+
+  // Create an entry for the file or directory at path. Throws std::filesystem::filesystem_error, if path cannot be accessed
+  static ArchiveEntry fromPath(std::string name, const std::filesystem::path& path);
+};
+
+// The content of an archive. The archive is not stored, but generated from its entries whenever it is read.
+// Only a window of the archive is kept in memory while it is read.
+class ArchiveSource: public File::Source {
+  // Lock the mutex, when accessing exactSize
+  std::mutex exactSizeMutex;
+  std::optional<size_t> exactSize;
+
+ protected:
+  std::vector<ArchiveEntry> entries;
+  size_t bufferSize;
+  bool memoryMap;
+
+ public:
+  ArchiveSource(std::vector<ArchiveEntry> entries, size_t bufferSize, bool memoryMap);
+  // The size of most archives is only known after they are generated. Then this returns an upper bound
+  [[nodiscard]] size_t getSize() const override = 0;
+  [[nodiscard]] bool isSizeKnown() const override;
+  // Generates the archive and discards it to count its bytes, if its size is not known. Generating is deterministic, so later reads
+  // produce exactly that many bytes
+  size_t getExactSize() override;
+  size_t read(size_t offset, char* buffer, size_t length) override;
+  // Archives are never kept in memory completely, so this throws std::runtime_error. Use readChunks instead
+  std::string_view getContent() override;
+  bool readChunks(const File::ChunkCallback& callback, size_t offset, size_t chunkSize) override;
+
+ protected:
+  // Generate the complete archive and pass it to callback. Returns false, if the callback stopped.
+  // Throws std::runtime_error, if reading an entry failed
+  virtual bool write(const File::ChunkCallback& callback) = 0;
+  // Read the content of a file entry
+  [[nodiscard]] File openEntry(const ArchiveEntry& entry) const;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "backendstatistics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+void BackendStatistics::recordLatency(const std::string& backend, double seconds) {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed = true;
+  Stats& backendStats = stats[backend];
+  mix(backendStats.latency, seconds);
+  backendStats.lastCheck = std::chrono::system_clock::now();
+  backendStats.reachable = true;
+}
+
+void BackendStatistics::recordUnreachable(const std::string& backend) {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed = true;
+  Stats& backendStats = stats[backend];
+  backendStats.lastCheck = std::chrono::system_clock::now();
+  backendStats.reachable = false;
+}
+
+void BackendStatistics::recordUpload(const std::string& backend, size_t size, double seconds) {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed = true;
+  Stats& backendStats = stats[backend];
+  backendStats.uploads++;
+  mix(backendStats.failureRate, 0);
+  // A successful upload is as good as a check
+  backendStats.lastCheck = std::chrono::system_clock::now();
+  backendStats.reachable = true;
+  if(size < minThroughputSize) {
+    // Small uploads take about as long as a request without content
+    mix(backendStats.latency, seconds);
+    return;
+  }
+  double transferTime = std::max(seconds - backendStats.latency.value_or(0), seconds / 10);
+  mix(backendStats.throughput, static_cast<double>(size) / transferTime);
+}
+
+void BackendStatistics::recordFailure(const std::string& backend) {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed = true;
+  Stats& backendStats = stats[backend];
+  backendStats.uploads++;
+  mix(backendStats.failureRate, 1);
+}
+
+BackendStatistics::Stats BackendStatistics::getStats(const std::string& backend) const {
+  std::unique_lock<std::mutex> lock(mutex);
+  auto backendStats = stats.find(backend);
+  return backendStats == stats.end() ? Stats{} : backendStats->second;
+}
+
+double BackendStatistics::getExpectedTime(const std::string& backend, size_t size) const {
+  Stats backendStats = getStats(backend);
+  double time = backendStats.latency.value_or(defaultLatency) + static_cast<double>(size) / backendStats.throughput.value_or(defaultThroughput);
+  // A backend that always fails is still better than no backend
+  return time / std::max(1 - backendStats.failureRate, 0.05);
+}
+
+BackendStatistics::Health BackendStatistics::getHealth(const std::string& backend, std::chrono::milliseconds maxAge) const {
+  Stats backendStats = getStats(backend);
+  auto now = std::chrono::system_clock::now();
+  // Checks from the future are caused by a changed clock and are not trusted
+  if(!backendStats.lastCheck || *backendStats.lastCheck > now || now - *backendStats.lastCheck > maxAge) {
+    return Health::Unknown;
+  }
+  return backendStats.reachable ? Health::Reachable : Health::Unreachable;
+}
+
+namespace {
+
+std::string formatOptional(const std::optional<double>& value) {
+  if(!value) {
+    return "-";
+  }
+  std::stringstream stream;
+  stream << *value;
+  return stream.str();
+}
+
+std::optional<double> parseOptional(const std::string& value) {
+  if(value == "-") {
+    return std::nullopt;
+  }
+  return std::stod(value);
+}
+
+}  // namespace
+
+bool BackendStatistics::isChanged() const {
+  std::unique_lock<std::mutex> lock(mutex);
+  return changed;
+}
+
+bool BackendStatistics::load(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::string line;
+  if(!std::getline(file, line) || line != cacheHeader) {
+    return false;
+  }
+
+  std::map<std::string, Stats> loadedStats;
+  while(std::getline(file, line)) {
+    std::vector<std::string> fields;
+    std::stringstream lineStream(line);
+    for(std::string field; std::getline(lineStream, field, '\t');) {
+      fields.push_back(field);
+    }
+    if(fields.size() != 7) {
+      continue;
+    }
+    try {
+      Stats backendStats;
+      if(fields[1] != "-") {
+        backendStats.lastCheck = std::chrono::system_clock::time_point(std::chrono::seconds(std::stoll(fields[1])));
+      }
+      backendStats.reachable = fields[2] == "1";
+      backendStats.latency = parseOptional(fields[3]);
+      backendStats.throughput = parseOptional(fields[4]);
+      backendStats.failureRate = std::clamp(std::stod(fields[5]), 0.0, 1.0);
+      backendStats.uploads = static_cast<unsigned int>(std::stoul(fields[6]));
+      loadedStats[fields[0]] = backendStats;
+    } catch(const std::exception&) {
+      // A broken line only loses the statistics of one backend
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  // Measurements of this invocation are newer than the cache, so they are kept
+  stats.merge(loadedStats);
+  return true;
+}
+
+bool BackendStatistics::save(const std::filesystem::path& path) {
+  std::stringstream content;
+  content << cacheHeader << '\n';
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed = false;
+    for(const auto& [name, backendStats] : stats) {
+      if(name.find_first_of("\t\n") != std::string::npos) {
+        continue;
+      }
+      content << name << '\t';
+      if(backendStats.lastCheck) {
+        content << std::chrono::duration_cast<std::chrono::seconds>(backendStats.lastCheck->time_since_epoch()).count();
+      } else {
+        content << '-';
+      }
+      content << '\t' << (backendStats.reachable ? 1 : 0) << '\t' << formatOptional(backendStats.latency) << '\t'
+              << formatOptional(backendStats.throughput) << '\t' << backendStats.failureRate << '\t' << backendStats.uploads << '\n';
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(saveMutex);
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  if(error) {
+    return false;
+  }
+  // Other invocations may read the cache at the same time, so it is replaced atomically
+  std::filesystem::path temporaryPath = path;
+#ifdef __unix__
+  temporaryPath += "." + std::to_string(getpid());
+#endif
+  temporaryPath += ".tmp";
+  {
+    std::ofstream file(temporaryPath, std::ios::trunc);
+    file << content.str();
+    if(!file) {
+      std::filesystem::remove(temporaryPath, error);
+      return false;
+    }
+  }
+  std::filesystem::rename(temporaryPath, path, error);
+  if(error) {
+    std::filesystem::remove(temporaryPath, error);
+    return false;
+  }
+  return true;
+}
+
+std::optional<std::filesystem::path> BackendStatistics::getDefaultCachePath() {
+  const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+  if(cacheHome != nullptr && *cacheHome != '\0') {
+    return std::filesystem::path(cacheHome) / "upload" / "backends";
+  }
+  const char* home = std::getenv("HOME");
+  if(home != nullptr && *home != '\0') {
+    return std::filesystem::path(home) / ".cache" / "upload" / "backends";
+  }
+  return std::nullopt;
+}
+
+void BackendStatistics::mix(std::optional<double>& average, double value) {
+  average = average ? *average + smoothing * (value - *average) : value;
+}
+
+void BackendStatistics::mix(double& average, double value) {
+  average += smoothing * (value - average);
+}
@@ -0,0 +1,77 @@
+#ifndef BACKEND_STATISTICS_HPP
+#define BACKEND_STATISTICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+// Measures how fast and reliable backends are. New measurements are mixed into moving averages, so recent measurements count more.
+// The statistics can be saved to a cache file, so later invocations know the backends without checking them. Can be used from multiple
+// threads.
+class BackendStatistics {
+ public:
+  struct Stats {
+    // Seconds until a backend answers a request without content
+    std::optional<double> latency;
+    // Bytes per second, without the latency
+    std::optional<double> throughput;
+    // Fraction of the uploads that failed
+    double failureRate = 0;
+    unsigned int uploads = 0;
+    // The time of the last check and its result
+    std::optional<std::chrono::system_clock::time_point> lastCheck;
+    bool reachable = false;
+  };
+
+  enum class Health { Unknown, Reachable, Unreachable };
+
+ private:
+  // How much a new measurement changes the averages
+  static constexpr double smoothing = 0.3;
+  // Uploads smaller than this are dominated by the latency, so they are not used to measure the throughput
+  static constexpr size_t minThroughputSize = 256 * 1024;
+  // Used for backends whose throughput was not measured yet
+  static constexpr double defaultThroughput = 1024 * 1024;
+  static constexpr double defaultLatency = 1;
+  // The first line of the cache file. Change it, when the format changes
+  static constexpr auto cacheHeader = "upload backend statistics 1";
+
+  // Lock the mutex, when accessing stats
+  mutable std::mutex mutex;
+  std::map<std::string, Stats> stats;
+  // Set by new measurements, until the statistics are saved
+  bool changed = false;
+  // Lock the mutex, when writing the cache file
+  std::mutex saveMutex;
+
+ public:
+  // Record a successful check, which took seconds
+  void recordLatency(const std::string& backend, double seconds);
+  void recordUnreachable(const std::string& backend);
+  void recordUpload(const std::string& backend, size_t size, double seconds);
+  void recordFailure(const std::string& backend);
+  [[nodiscard]] Stats getStats(const std::string& backend) const;
+  // The expected number of seconds until a file of size is uploaded. Failures count as the time it takes to upload again
+  [[nodiscard]] double getExpectedTime(const std::string& backend, size_t size) const;
+  // The result of the last check, if it is not older than maxAge
+  [[nodiscard]] Health getHealth(const std::string& backend, std::chrono::milliseconds maxAge) const;
+
+  // Check for measurements, that were not saved yet
+  [[nodiscard]] bool isChanged() const;
+  // Merge the statistics from the cache file at path into the current statistics. Returns false, if the file could not be read
+  bool load(const std::filesystem::path& path);
+  // Replace the cache file at path. Returns false, if the file could not be written
+  bool save(const std::filesystem::path& path);
+  // $XDG_CACHE_HOME/upload/backends or ~/.cache/upload/backends. Returns nullopt, if neither variable is set
+  [[nodiscard]] static std::optional<std::filesystem::path> getDefaultCachePath();
+
+ private:
+  static void mix(std::optional<double>& average, double value);
+  static void mix(double& average, double value);
+};
+
+#endif
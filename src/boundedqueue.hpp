@@ -0,0 +1,82 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <queue>
+
+// A queue with a maximum size, that can be used by multiple producers and consumers.
+// Producers wait while the queue is full, consumers wait while it is empty. After the queue is closed, consumers receive the
+// remaining elements and then std::nullopt.
+template<typename T>
+class BoundedQueue {
+  size_t capacity;
+  bool closed;
+  std::queue<T> elements;
+
+  // Lock the mutex, when accessing elements or closed
+  std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+
+ public:
+  explicit BoundedQueue(size_t capacity);
+  BoundedQueue(const BoundedQueue&) = delete;
+  // Wait until there is space in the queue and add element. Returns false, if the queue is closed
+  bool push(T element);
+  // Wait until an element is available and remove it. Returns std::nullopt, if the queue is closed and empty
+  std::optional<T> pop();
+  // No more elements will be pushed
+  void close();
+};
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity): capacity(capacity == 0 ? 1 : capacity), closed(false) {}
+
+template<typename T>
+bool BoundedQueue<T>::push(T element) {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this]() {
+      return elements.size() < capacity || closed;
+    });
+    if(closed) {
+      return false;
+    }
+    elements.push(std::move(element));
+  }
+  notEmpty.notify_one();
+  return true;
+}
+
+template<typename T>
+std::optional<T> BoundedQueue<T>::pop() {
+  std::optional<T> element;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this]() {
+      return !elements.empty() || closed;
+    });
+    if(elements.empty()) {
+      return std::nullopt;
+    }
+    element = std::move(elements.front());
+    elements.pop();
+  }
+  notFull.notify_one();
+  return element;
+}
+
+template<typename T>
+void BoundedQueue<T>::close() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+  }
+  notFull.notify_all();
+  notEmpty.notify_all();
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "compressor.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <zip_file.hpp>
+#include <zstd.h>
+
+struct Deflater::State {
+  mz_stream stream;
+};
+
+Deflater::Deflater(int level, size_t bufferSize): state(std::make_unique<State>()), outputBuffer(bufferSize) {
+  state->stream = {};
+  // Negative window bits create a raw deflate stream without zlib header
+  if(mz_deflateInit2(&state->stream, level, MZ_DEFLATED, -MZ_DEFAULT_WINDOW_BITS, 9, MZ_DEFAULT_STRATEGY) != MZ_OK) {
+    throw std::runtime_error("Failed to initialize deflate compression.");
+  }
+}
+
+Deflater::~Deflater() {
+  mz_deflateEnd(&state->stream);
+}
+
+bool Deflater::compress(const char* data, size_t length, const File::ChunkCallback& callback) {
+  return deflate(data, length, MZ_NO_FLUSH, callback);
+}
+
+bool Deflater::flush(const File::ChunkCallback& callback) {
+  return deflate(nullptr, 0, MZ_SYNC_FLUSH, callback);
+}
+
+bool Deflater::finish(const File::ChunkCallback& callback) {
+  return deflate(nullptr, 0, MZ_FINISH, callback);
+}
+
+void Deflater::reset() {
+  if(mz_deflateReset(&state->stream) != MZ_OK) {
+    throw std::runtime_error("Failed to reset deflate compression.");
+  }
+}
+
+bool Deflater::deflate(const char* data, size_t length, int flush, const File::ChunkCallback& callback) {
+  mz_stream& stream = state->stream;
+  stream.next_in = reinterpret_cast<const unsigned char*>(data);
+  stream.avail_in = static_cast<unsigned int>(length);
+  while(true) {
+    stream.next_out = outputBuffer.data();
+    stream.avail_out = static_cast<unsigned int>(outputBuffer.size());
+    int status = mz_deflate(&stream, flush);
+    if(status != MZ_OK && status != MZ_STREAM_END && status != MZ_BUF_ERROR) {
+      throw std::runtime_error("Failed to compress data.");
+    }
+    size_t produced = outputBuffer.size() - stream.avail_out;
+    if(produced > 0 && !callback(reinterpret_cast<const char*>(outputBuffer.data()), produced)) {
+      return false;
+    }
+    if(status == MZ_STREAM_END) {
+      return true;
+    }
+    // Continue while the output buffer was filled completely, because there may be more pending output
+    if(stream.avail_in == 0 && stream.avail_out != 0 && flush != MZ_FINISH) {
+      return true;
+    }
+    if(status == MZ_BUF_ERROR && produced == 0) {
+      return true;
+    }
+  }
+}
+
+namespace {
+
+unsigned int resolveThreadCount(unsigned int threads) {
+  return threads != 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+}  // namespace
+
+BlockDeflater::BlockDeflater(unsigned int threads, int level): level(level), tasks(2 * resolveThreadCount(threads)) {
+  threads = resolveThreadCount(threads);
+  for(unsigned int i = 0; i < threads; i++) {
+    workers.emplace_back([this]() {
+      // Every worker reuses its deflater, because creating one is expensive
+      Deflater deflater(this->level);
+      while(std::optional<Task> task = tasks.pop()) {
+        (*task)(deflater);
+      }
+    });
+  }
+}
+
+BlockDeflater::~BlockDeflater() {
+  tasks.close();
+}
+
+unsigned int BlockDeflater::getThreadCount() const {
+  return static_cast<unsigned int>(workers.size());
+}
+
+std::future<std::string> BlockDeflater::compress(std::string block) {
+  Task task([block = std::move(block)](Deflater& deflater) {
+    std::string compressed;
+    compressed.reserve(block.size() / 2);
+    deflater.reset();
+    deflater.compress(block.data(), block.size(), [&compressed](const char* data, size_t length) {
+      compressed.append(data, length);
+      return true;
+    });
+    deflater.flush([&compressed](const char* data, size_t length) {
+      compressed.append(data, length);
+      return true;
+    });
+    return compressed;
+  });
+  std::future<std::string> result = task.get_future();
+  tasks.push(std::move(task));
+  return result;
+}
+
+StreamCompressor::StreamCompressor(File::ChunkCallback output): output(std::move(output)) {}
+
+GzipCompressor::GzipCompressor(File::ChunkCallback output, unsigned int threads, int level)
+    : StreamCompressor(std::move(output)), deflater(threads, level), headerWritten(false), crc(0), size(0) {}
+
+bool GzipCompressor::write(const char* data, size_t length) {
+  crc = crc32(crc, data, length);
+  size += length;
+  while(length > 0) {
+    size_t copied = std::min(BlockDeflater::blockSize - block.size(), length);
+    block.append(data, copied);
+    data += copied;
+    length -= copied;
+    if(block.size() == BlockDeflater::blockSize && !submitBlock()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GzipCompressor::finish() {
+  if(!block.empty() && !submitBlock()) {
+    return false;
+  }
+  if(!writePending(0)) {
+    return false;
+  }
+  std::string trailer(BlockDeflater::finalBlock);
+  // Crc and size modulo 2^32 in little endian
+  for(uint64_t value : {uint64_t(crc), size}) {
+    for(int i = 0; i < 4; i++) {
+      trailer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+  }
+  return output(trailer.data(), trailer.size());
+}
+
+bool GzipCompressor::submitBlock() {
+  pending.push_back(deflater.compress(std::move(block)));
+  block.clear();
+  // Enough blocks to keep every worker busy, while the oldest block is written
+  return writePending(2 * deflater.getThreadCount());
+}
+
+bool GzipCompressor::writePending(size_t maxBlocks) {
+  if(!headerWritten) {
+    // Deflate, no flags, no modification time, no extra flags, unix
+    static constexpr char header[] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3};
+    if(!output(header, sizeof(header))) {
+      return false;
+    }
+    headerWritten = true;
+  }
+  while(pending.size() > maxBlocks) {
+    std::string data = pending.front().get();
+    pending.pop_front();
+    if(!output(data.data(), data.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct ZstdCompressor::State {
+  ZSTD_CCtx* context;
+};
+
+ZstdCompressor::ZstdCompressor(File::ChunkCallback output, unsigned int threads, int level)
+    : StreamCompressor(std::move(output)), state(std::make_unique<State>()), outputBuffer(ZSTD_CStreamOutSize()) {
+  state->context = ZSTD_createCCtx();
+  if(state->context == nullptr) {
+    throw std::runtime_error("Failed to initialize zstd compression.");
+  }
+  if(ZSTD_isError(ZSTD_CCtx_setParameter(state->context, ZSTD_c_compressionLevel, level))) {
+    ZSTD_freeCCtx(state->context);
+    throw std::runtime_error("Failed to set the zstd compression level.");
+  }
+  // Fails, if zstd was built without multithreading support. Compressing with one thread works anyway
+  ZSTD_CCtx_setParameter(state->context, ZSTD_c_nbWorkers, static_cast<int>(resolveThreadCount(threads)));
+}
+
+ZstdCompressor::~ZstdCompressor() {
+  ZSTD_freeCCtx(state->context);
+}
+
+bool ZstdCompressor::write(const char* data, size_t length) {
+  return compress(data, length, false);
+}
+
+bool ZstdCompressor::finish() {
+  return compress(nullptr, 0, true);
+}
+
+bool ZstdCompressor::compress(const char* data, size_t length, bool end) {
+  ZSTD_inBuffer input{data, length, 0};
+  while(true) {
+    ZSTD_outBuffer outputWindow{outputBuffer.data(), outputBuffer.size(), 0};
+    size_t remaining = ZSTD_compressStream2(state->context, &outputWindow, &input, end ? ZSTD_e_end : ZSTD_e_continue);
+    if(ZSTD_isError(remaining)) {
+      throw std::runtime_error(std::string("Failed to compress data. ") + ZSTD_getErrorName(remaining));
+    }
+    if(outputWindow.pos > 0 && !output(outputBuffer.data(), outputWindow.pos)) {
+      return false;
+    }
+    if(end ? remaining == 0 : input.pos == input.size) {
+      return true;
+    }
+  }
+}
+
+uint32_t crc32(uint32_t crc, const char* data, size_t length) {
+  return static_cast<uint32_t>(mz_crc32(crc, reinterpret_cast<const unsigned char*>(data), length));
+}
@@ -0,0 +1,126 @@
+#ifndef COMPRESSOR_HPP
+#define COMPRESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "boundedqueue.hpp"
+#include "file.hpp"
+
+// Compresses a stream of data into a raw deflate stream.
+class Deflater {
+  // Hides the miniz stream, so miniz is only included in one translation unit
+  struct State;
+  std::unique_ptr<State> state;
+  std::vector<unsigned char> outputBuffer;
+
+ public:
+  static constexpr int defaultLevel = 6;
+
+  explicit Deflater(int level = defaultLevel, size_t bufferSize = File::defaultBufferSize);
+  Deflater(const Deflater&) = delete;
+  ~Deflater();
+  // Compress data. Compressed output is passed to callback, whenever the output buffer is full.
+  // Returns false, if the callback stopped. Throws std::runtime_error, if compressing failed
+  bool compress(const char* data, size_t length, const File::ChunkCallback& callback);
+  // Compress all pending data and align the output to a byte boundary, without ending the stream.
+  bool flush(const File::ChunkCallback& callback);
+  // Compress all pending data and end the stream.
+  bool finish(const File::ChunkCallback& callback);
+  // Start a new stream with the same settings
+  void reset();
+
+ private:
+  bool deflate(const char* data, size_t length, int flush, const File::ChunkCallback& callback);
+};
+
+// Compresses blocks of a deflate stream on a pool of worker threads. Each block is compressed independently and ends on a byte
+// boundary, so the compressed blocks can be concatenated in their original order. The result does not depend on the number of threads.
+class BlockDeflater {
+  using Task = std::packaged_task<std::string(Deflater&)>;
+
+  int level;
+  BoundedQueue<Task> tasks;
+  std::vector<std::jthread> workers;
+
+ public:
+  // Appended to the concatenated blocks to end the deflate stream. It is an empty final block with fixed huffman codes.
+  static constexpr std::string_view finalBlock{"\x03\x00", 2};
+  // Every block starts without history, so smaller blocks compress worse
+  static constexpr size_t blockSize = 1024 * 1024;
+
+  // Uses one thread per core, if threads is 0
+  explicit BlockDeflater(unsigned int threads, int level = Deflater::defaultLevel);
+  BlockDeflater(const BlockDeflater&) = delete;
+  ~BlockDeflater();
+  [[nodiscard]] unsigned int getThreadCount() const;
+  // Compress a block. The future throws std::runtime_error, if compressing failed
+  std::future<std::string> compress(std::string block);
+};
+
+// Compresses a stream of data and passes the compressed data to an output callback
+class StreamCompressor {
+ protected:
+  File::ChunkCallback output;
+
+ public:
+  explicit StreamCompressor(File::ChunkCallback output);
+  virtual ~StreamCompressor() = default;
+  // Compress data. Returns false, if the output callback stopped. Throws std::runtime_error, if compressing failed
+  virtual bool write(const char* data, size_t length) = 0;
+  // Compress all pending data and end the stream.
+  virtual bool finish() = 0;
+};
+
+// Creates a gzip stream. The blocks of the stream are compressed in parallel by a BlockDeflater.
+class GzipCompressor: public StreamCompressor {
+  BlockDeflater deflater;
+  std::string block;
+  std::deque<std::future<std::string>> pending;
+  bool headerWritten;
+  uint32_t crc;
+  uint64_t size;
+
+ public:
+  static constexpr int defaultLevel = Deflater::defaultLevel;
+
+  GzipCompressor(File::ChunkCallback output, unsigned int threads, int level = defaultLevel);
+  bool write(const char* data, size_t length) override;
+  bool finish() override;
+
+ private:
+  bool submitBlock();
+  // Write compressed blocks until at most maxBlocks are pending
+  bool writePending(size_t maxBlocks);
+};
+
+// Creates a zstd stream. Zstd compresses with multiple threads itself.
+class ZstdCompressor: public StreamCompressor {
+  // Hides the zstd context, so zstd is only included in one translation unit
+  struct State;
+  std::unique_ptr<State> state;
+  std::vector<char> outputBuffer;
+
+ public:
+  static constexpr int defaultLevel = 3;
+
+  ZstdCompressor(File::ChunkCallback output, unsigned int threads, int level = defaultLevel);
+  ~ZstdCompressor() override;
+  bool write(const char* data, size_t length) override;
+  bool finish() override;
+
+ private:
+  bool compress(const char* data, size_t length, bool end);
+};
+
+// Update the crc32 checksum crc with data. Use 0 as initial value.
+uint32_t crc32(uint32_t crc, const char* data, size_t length);
+
+#endif
@@ -0,0 +1,214 @@
+#include "directorywalker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __unix__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::string joinName(const std::string& directory, const std::string& name) {
+  return directory.empty() ? name : directory + "/" + name;
+}
+
+std::string describeNeitherFileNorDirectory(const std::filesystem::path& path) {
+  return "Only regular files and directories can be archived. You tried to archive " + path.string() + ", which is neither.";
+}
+
+#ifdef __unix__
+
+// The directories of one thread. Other threads steal from the front, while the owner works from the back.
+struct WorkQueue {
+  std::mutex mutex;
+  // Paths relative to the root
+  std::deque<std::string> directories;
+};
+
+class ParallelWalk {
+  const std::filesystem::path& root;
+  int rootDescriptor;
+  std::vector<WorkQueue> queues;
+  // Directories that are queued or being read
+  std::atomic<size_t> pendingDirectories;
+  // Changes, when a directory is queued or the last directory was read, so idle threads can sleep until then
+  std::atomic<size_t> progress;
+  std::vector<DirectoryWalker::Result> results;
+
+ public:
+  ParallelWalk(const std::filesystem::path& root, int rootDescriptor, unsigned int threads)
+      : root(root), rootDescriptor(rootDescriptor), queues(threads), pendingDirectories(1), progress(0), results(threads) {
+    queues[0].directories.emplace_back("");
+  }
+
+  DirectoryWalker::Result run() {
+    {
+      std::vector<std::jthread> workers;
+      for(size_t i = 0; i < queues.size(); i++) {
+        workers.emplace_back([this, i]() {
+          work(i);
+        });
+      }
+    }
+    DirectoryWalker::Result result;
+    for(DirectoryWalker::Result& partialResult : results) {
+      std::move(partialResult.entries.begin(), partialResult.entries.end(), std::back_inserter(result.entries));
+      std::move(partialResult.errors.begin(), partialResult.errors.end(), std::back_inserter(result.errors));
+    }
+    return result;
+  }
+
+ private:
+  void work(size_t index) {
+    while(true) {
+      // Read before looking for work, so a directory that is queued meanwhile wakes this thread
+      size_t observedProgress = progress;
+      std::optional<std::string> directory = takeDirectory(index);
+      if(!directory) {
+        if(pendingDirectories == 0) {
+          return;
+        }
+        // Another thread is still reading a directory, that may contain more directories
+        progress.wait(observedProgress);
+        continue;
+      }
+      readDirectory(*directory, index);
+      if(--pendingDirectories == 0) {
+        progress++;
+        progress.notify_all();
+      }
+    }
+  }
+
+  std::optional<std::string> takeDirectory(size_t index) {
+    {
+      std::unique_lock<std::mutex> lock(queues[index].mutex);
+      if(!queues[index].directories.empty()) {
+        std::string directory = std::move(queues[index].directories.back());
+        queues[index].directories.pop_back();
+        return directory;
+      }
+    }
+    for(size_t offset = 1; offset < queues.size(); offset++) {
+      WorkQueue& victim = queues[(index + offset) % queues.size()];
+      std::unique_lock<std::mutex> lock(victim.mutex);
+      if(!victim.directories.empty()) {
+        std::string directory = std::move(victim.directories.front());
+        victim.directories.pop_front();
+        return directory;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void readDirectory(const std::string& directory, size_t index) {
+    DirectoryWalker::Result& result = results[index];
+    int descriptor = directory.empty() ? dup(rootDescriptor) : openat(rootDescriptor, directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+    DIR* stream = descriptor < 0 ? nullptr : fdopendir(descriptor);
+    if(stream == nullptr) {
+      if(descriptor >= 0) {
+        close(descriptor);
+      }
+      result.errors.push_back("Failed to open the directory " + (root / directory).string() + " . " + std::strerror(errno));
+      return;
+    }
+
+    while(dirent* child = readdir(stream)) {
+      if(std::strcmp(child->d_name, ".") == 0 || std::strcmp(child->d_name, "..") == 0) {
+        continue;
+      }
+      std::string name = joinName(directory, child->d_name);
+      // The type from the directory saves following everything that is not a symlink
+      bool symlink = child->d_type == DT_LNK;
+      struct stat status;
+      int statResult = fstatat(dirfd(stream), child->d_name, &status, symlink ? 0 : AT_SYMLINK_NOFOLLOW);
+      if(statResult == 0 && S_ISLNK(status.st_mode)) {
+        // Only happens for file systems, that do not report the type
+        symlink = true;
+        statResult = fstatat(dirfd(stream), child->d_name, &status, 0);
+      }
+      if(statResult != 0) {
+        result.errors.push_back("Failed to get information about the file " + (root / name).string() + " . " + std::strerror(errno));
+        continue;
+      }
+
+      bool isDirectory = S_ISDIR(status.st_mode);
+      if(!isDirectory && !S_ISREG(status.st_mode)) {
+        result.errors.push_back(describeNeitherFileNorDirectory(root / name));
+        continue;
+      }
+      ArchiveEntry entry;
+      entry.name = name;
+      entry.path = root / name;
+      entry.directory = isDirectory;
+      entry.size = isDirectory ? 0 : static_cast<size_t>(status.st_size);
+      entry.modificationTime = status.st_mtime;
+      entry.permissions = static_cast<std::filesystem::perms>(status.st_mode & 07777);
+      result.entries.push_back(std::move(entry));
+
+      if(isDirectory && !symlink) {
+        pendingDirectories++;
+        {
+          std::unique_lock<std::mutex> lock(queues[index].mutex);
+          queues[index].directories.push_back(name);
+        }
+        progress++;
+        progress.notify_one();
+      }
+    }
+    closedir(stream);
+  }
+};
+
+#endif
+
+}  // namespace
+
+DirectoryWalker::DirectoryWalker(unsigned int threads): threads(threads != 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u)) {}
+
+DirectoryWalker::Result DirectoryWalker::walk(const std::filesystem::path& root, const std::string& prefix) const {
+  Result result;
+#ifdef __unix__
+  // Directories are opened relative to the root, so the number of open directories stays small
+  int rootDescriptor = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if(rootDescriptor < 0) {
+    throw std::runtime_error("Failed to open the directory " + root.string() + " . " + std::strerror(errno));
+  }
+  result = ParallelWalk(root, rootDescriptor, threads).run();
+  close(rootDescriptor);
+#else
+  try {
+    for(const auto& child : std::filesystem::recursive_directory_iterator(root)) {
+      std::filesystem::path name = std::filesystem::relative(child.path(), root);
+      if(!child.is_directory() && !child.is_regular_file()) {
+        result.errors.push_back(describeNeitherFileNorDirectory(child.path()));
+        continue;
+      }
+      result.entries.push_back(ArchiveEntry::fromPath(name.generic_string(), child.path()));
+    }
+  } catch(const std::filesystem::filesystem_error& error) {
+    result.errors.push_back(error.what());
+  }
+#endif
+
+  // The order of a parallel walk is random, but the archives should not be
+  std::sort(result.entries.begin(), result.entries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) {
+    return a.name < b.name;
+  });
+  if(!prefix.empty()) {
+    for(ArchiveEntry& entry : result.entries) {
+      entry.name = joinName(prefix, entry.name);
+    }
+  }
+  return result;
+}
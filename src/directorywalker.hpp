@@ -0,0 +1,33 @@
+#ifndef DIRECTORY_WALKER_HPP
+#define DIRECTORY_WALKER_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "archive.hpp"
+
+// Lists everything below a directory with multiple threads. Every thread works on its own queue of directories and steals
+// directories from the other queues, when its own queue is empty.
+// Each entry costs one stat call relative to its directory. Symlinks are followed, but directories behind symlinks are not entered.
+class DirectoryWalker {
+ public:
+  struct Result {
+    // Sorted by name
+    std::vector<ArchiveEntry> entries;
+    // Entries that could not be listed, with a message for each of them
+    std::vector<std::string> errors;
+  };
+
+ private:
+  unsigned int threads;
+
+ public:
+  // Uses one thread per core, if threads is 0
+  explicit DirectoryWalker(unsigned int threads = 0);
+  // List everything below root. The names of the entries are relative to root and start with prefix, if it is not empty.
+  // Throws std::runtime_error, if root cannot be opened
+  [[nodiscard]] Result walk(const std::filesystem::path& root, const std::string& prefix = "") const;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "directorywatcher.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+DirectoryWatcher::DirectoryWatcher(std::filesystem::path directory, std::chrono::milliseconds delay)
+    : directory(std::move(directory)), delay(delay), descriptor(-1), lastRead(std::filesystem::file_time_type::clock::now()) {
+#ifdef __linux__
+  descriptor = inotify_init1(IN_CLOEXEC);
+  if(descriptor < 0) {
+    throw std::runtime_error(std::string("Failed to watch the directory ") + this->directory.string() + " . " + std::strerror(errno));
+  }
+  // Files that are still written are not interesting, so only closing after writing and moving into the directory count
+  uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+  if(inotify_add_watch(descriptor, this->directory.c_str(), mask) < 0) {
+    std::string message = std::string("Failed to watch the directory ") + this->directory.string() + " . " + std::strerror(errno);
+    close(descriptor);
+    throw std::runtime_error(message);
+  }
+#else
+  throw std::runtime_error("Watching directories is only supported on linux.");
+#endif
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __linux__
+  close(descriptor);
+#endif
+}
+
+std::vector<std::filesystem::path> DirectoryWatcher::wait() {
+#ifdef __linux__
+  while(true) {
+    std::vector<std::filesystem::path> readyFiles = takeReadyFiles();
+    if(!readyFiles.empty()) {
+      return readyFiles;
+    }
+
+    // Sleep until the next pending file is ready or something happens
+    int timeout = -1;
+    if(!pendingFiles.empty()) {
+      auto now = std::chrono::steady_clock::now();
+      auto nextReady = std::min_element(pendingFiles.begin(), pendingFiles.end(), [](const auto& a, const auto& b) {
+                         return a.second < b.second;
+                       })->second +
+                       delay;
+      timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(std::max(nextReady - now, std::chrono::steady_clock::duration::zero())).count());
+    }
+    pollfd pollDescriptor{descriptor, POLLIN, 0};
+    int result = poll(&pollDescriptor, 1, timeout);
+    if(result < 0 && errno != EINTR) {
+      throw std::runtime_error(std::string("Failed to watch the directory ") + directory.string() + " . " + std::strerror(errno));
+    }
+    if(result > 0) {
+      readEvents();
+    }
+  }
+#else
+  return {};
+#endif
+}
+
+void DirectoryWatcher::readEvents() {
+#ifdef __linux__
+  alignas(inotify_event) char buffer[64 * 1024];
+  std::filesystem::file_time_type previousRead = lastRead;
+  lastRead = std::filesystem::file_time_type::clock::now();
+  ssize_t length = read(descriptor, buffer, sizeof(buffer));
+  if(length < 0) {
+    if(errno == EINTR || errno == EAGAIN) {
+      return;
+    }
+    throw std::runtime_error(std::string("Failed to watch the directory ") + directory.string() + " . " + std::strerror(errno));
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  for(char* position = buffer; position < buffer + length;) {
+    const auto* event = reinterpret_cast<const inotify_event*>(position);
+    position += sizeof(inotify_event) + event->len;
+
+    if(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+      throw std::runtime_error("The watched directory " + directory.string() + " was removed.");
+    }
+    if(event->mask & IN_Q_OVERFLOW) {
+      // The kernel dropped events, so the files written since the last read are found by their modification time instead
+      logger.log(Logger::Info) << "Too many changes in " << directory.string() << " at once, rescanning it." << '\n';
+      rescan(previousRead);
+      continue;
+    }
+    if(event->len == 0) {
+      continue;
+    }
+    std::string name(event->name);
+    if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+      // Every write restarts the delay
+      pendingFiles[name] = now;
+    } else if(event->mask & (IN_MOVED_FROM | IN_DELETE)) {
+      pendingFiles.erase(name);
+    }
+  }
+#endif
+}
+
+void DirectoryWatcher::rescan(std::filesystem::file_time_type since) {
+  auto now = std::chrono::steady_clock::now();
+  std::error_code error;
+  for(const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+    std::error_code entryError;
+    if(entry.is_regular_file(entryError) && entry.last_write_time(entryError) >= since && !entryError) {
+      pendingFiles[entry.path().filename().string()] = now;
+    }
+  }
+  if(error) {
+    throw std::runtime_error("Failed to rescan the watched directory " + directory.string() + " . " + error.message());
+  }
+}
+
+std::vector<std::filesystem::path> DirectoryWatcher::takeReadyFiles() {
+  std::vector<std::pair<std::chrono::steady_clock::time_point, std::string>> readyNames;
+  auto now = std::chrono::steady_clock::now();
+  for(auto file = pendingFiles.begin(); file != pendingFiles.end();) {
+    if(now - file->second >= delay) {
+      readyNames.emplace_back(file->second, file->first);
+      file = pendingFiles.erase(file);
+    } else {
+      file++;
+    }
+  }
+  // Files that were written first are reported first
+  std::sort(readyNames.begin(), readyNames.end());
+  std::vector<std::filesystem::path> readyFiles;
+  for(const auto& [time, name] : readyNames) {
+    readyFiles.push_back(directory / name);
+  }
+  return readyFiles;
+}
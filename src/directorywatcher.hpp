@@ -0,0 +1,40 @@
+#ifndef DIRECTORY_WATCHER_HPP
+#define DIRECTORY_WATCHER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Reports files in a directory, after they were written and closed or moved into the directory.
+// A file is only reported, after it was not written to for a delay, so bursts of writes are reported once.
+// Watching directories is only supported on linux.
+class DirectoryWatcher {
+  std::filesystem::path directory;
+  std::chrono::milliseconds delay;
+  int descriptor;
+  // Names of the files, that were written, and the time of their last write
+  std::map<std::string, std::chrono::steady_clock::time_point> pendingFiles;
+  // When the events were last read. Files written since then are rescanned, if the event queue overflows
+  std::filesystem::file_time_type lastRead;
+
+ public:
+  // Throws std::runtime_error, if the directory cannot be watched
+  DirectoryWatcher(std::filesystem::path directory, std::chrono::milliseconds delay);
+  DirectoryWatcher(const DirectoryWatcher&) = delete;
+  ~DirectoryWatcher();
+  // Wait until files are ready and return their paths.
+  // Throws std::runtime_error, if the directory cannot be watched anymore
+  std::vector<std::filesystem::path> wait();
+
+ private:
+  // Read the available events and update the pending files
+  void readEvents();
+  // Add the files, that were written since the given time, to the pending files
+  void rescan(std::filesystem::file_time_type since);
+  // Remove the files, that were not written to for the delay, from the pending files and return their paths
+  std::vector<std::filesystem::path> takeReadyFiles();
+};
+
+#endif
@@ -13,7 +13,7 @@ inline std::vector<std::shared_ptr<Backend>> loadBackendsFromFile(const std::fil
     // Failed to open library
     std::string message(dlerror());
     logger.log(Logger::Info) << "Failed to load backend library " << file << "." << '\n';
-    logger.log(Logger::Debug) << "This is the error message from your system: " << message << '\n';
+    UPLOAD_LOG(Logger::Debug) << "This is the error message from your system: " << message << '\n';
     return std::vector<std::shared_ptr<Backend>>{};
   }
   BackendList (*load_backends_dynamically)();
@@ -23,12 +23,12 @@ inline std::vector<std::shared_ptr<Backend>> loadBackendsFromFile(const std::fil
   if(errorMessage != NULL) {
     // Library does not contain 'BackendList load_backends_dynamically()'
     logger.log(Logger::Info) << "The backend library " << file << " doesn't seem to be a valid upload backend." << '\n';
-    logger.log(Logger::Debug)
+    UPLOAD_LOG(Logger::Debug)
         << "Library " << file << " does not contain 'BackendList load_backends_dynamically()'. Check, if " << file
         << " really is an upload backend. If you build the library yourself you can use the setBackendType() macro to "
            "generate 'BackendList load_backends_dynamically()' for you. "
         << '\n';
-    logger.log(Logger::Debug) << "This is the error message from your system: " << errorMessage << '\n';
+    UPLOAD_LOG(Logger::Debug) << "This is the error message from your system: " << errorMessage << '\n';
     return std::vector<std::shared_ptr<Backend>>{};
   }
   BackendList loadedBackendList = load_backends_dynamically();
@@ -46,7 +46,7 @@ inline std::vector<std::filesystem::path> findLibraries() {
   std::string pluginDirectory;
 #ifndef UPLOAD_PLUGIN_DIR
 #warning "No plugin directory specified. You should define UPLOAD_PLUGIN_DIR as the directory where you want to load plugins from"
-  logger.log(Logger::Debug) << "No plugin directory specified. You should define UPLOAD_PLUGIN_DIR as the directory where you want to load "
+  UPLOAD_LOG(Logger::Debug) << "No plugin directory specified. You should define UPLOAD_PLUGIN_DIR as the directory where you want to load "
                                "plugins from, when building upload"
                             << '\n';
   return {};
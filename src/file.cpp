@@ -1,12 +1,220 @@
 #include "file.hpp"
 
-#include <map>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "logger.hpp"
+#include "mimetype.hpp"
 #include "quit.hpp"
 
-File::File(const std::filesystem::path& path) {
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Reads the content from a file on disk. The file is opened on the first read.
+class StreamSource: public File::Source {
+  std::filesystem::path path;
+  size_t size;
+  // Lock the mutex, when accessing stream
+  std::mutex streamMutex;
+  std::ifstream stream;
+  // Lock the mutex, when accessing content
+  std::mutex contentMutex;
+  std::unique_ptr<std::string> content;
+
+ public:
+  StreamSource(std::filesystem::path path, size_t size): path(std::move(path)), size(size) {}
+
+  [[nodiscard]] size_t getSize() const override {
+    return size;
+  }
+
+  size_t read(size_t offset, char* buffer, size_t length) override {
+    if(offset >= size) {
+      return 0;
+    }
+    length = std::min(length, size - offset);
+
+    std::unique_lock<std::mutex> lock(streamMutex);
+    if(!stream.is_open()) {
+      stream.open(path, std::ios::binary | std::ios::in);
+    }
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(offset));
+    stream.read(buffer, static_cast<std::streamsize>(length));
+    if(stream.bad() || static_cast<size_t>(stream.gcount()) != length) {
+      std::stringstream message;
+      message << "Failed to read " << path << ". Maybe it was modified while uploading?";
+      throw std::runtime_error(message.str());
+    }
+    return length;
+  }
+
+  std::string_view getContent() override {
+    std::unique_lock<std::mutex> lock(contentMutex);
+    if(content == nullptr) {
+      auto loadedContent = std::make_unique<std::string>(size, '\0');
+      read(0, loadedContent->data(), size);
+      content = std::move(loadedContent);
+    }
+    return *content;
+  }
+};
+
+// Provides content that is already in memory
+class MemorySource: public File::Source {
+  std::string content;
+
+ public:
+  explicit MemorySource(std::string content): content(std::move(content)) {}
+
+  [[nodiscard]] size_t getSize() const override {
+    return content.size();
+  }
+
+  size_t read(size_t offset, char* buffer, size_t length) override {
+    if(offset >= content.size()) {
+      return 0;
+    }
+    return content.copy(buffer, length, offset);
+  }
+
+  std::string_view getContent() override {
+    return content;
+  }
+
+  bool readChunks(const File::ChunkCallback& callback, size_t offset, size_t chunkSize) override {
+    for(; offset < content.size(); offset += chunkSize) {
+      if(!callback(content.data() + offset, std::min(chunkSize, content.size() - offset))) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+#ifdef __unix__
+// Maps a regular file into memory. The pages are loaded by the kernel on access and can be reclaimed under memory pressure.
+// Accessing pages after the end of a truncated file raises SIGBUS, so the size of the file is checked before every access.
+class MappedSource: public File::Source {
+  std::filesystem::path path;
+  int fd;
+  char* data;
+  size_t size;
+
+ public:
+  MappedSource(std::filesystem::path path, int fd, char* data, size_t size): path(std::move(path)), fd(fd), data(data), size(size) {}
+  MappedSource(const MappedSource&) = delete;
+  ~MappedSource() override {
+    munmap(data, size);
+    close(fd);
+  }
+
+  // Map the file at path. Returns nullptr, if the file cannot be mapped. Only non-empty regular files can be mapped.
+  static std::shared_ptr<MappedSource> map(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+      return nullptr;
+    }
+    struct stat fileStat {};
+    if(fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size <= 0) {
+      close(fd);
+      return nullptr;
+    }
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED) {
+      close(fd);
+      UPLOAD_LOG(Logger::Debug) << "Failed to map " << path << " into memory. Falling back to buffered reads." << '\n';
+      return nullptr;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    // The file stays open, so its size can be checked
+    return std::make_shared<MappedSource>(path, fd, static_cast<char*>(data), size);
+  }
+
+  [[nodiscard]] size_t getSize() const override {
+    return size;
+  }
+
+  size_t read(size_t offset, char* buffer, size_t length) override {
+    if(offset >= size) {
+      return 0;
+    }
+    length = std::min(length, size - offset);
+    checkSize(offset + length);
+    std::copy_n(data + offset, length, buffer);
+    return length;
+  }
+
+  // The view is only checked once, so callers should prefer readChunks
+  std::string_view getContent() override {
+    checkSize(size);
+    return {data, size};
+  }
+
+  bool readChunks(const File::ChunkCallback& callback, size_t offset, size_t chunkSize) override {
+    for(; offset < size; offset += chunkSize) {
+      size_t length = std::min(chunkSize, size - offset);
+      checkSize(offset + length);
+      if(!callback(data + offset, length)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Throws std::runtime_error, if the file is shorter than end now
+  void checkSize(size_t end) const {
+    struct stat fileStat {};
+    if(fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < end) {
+      std::stringstream message;
+      message << "Failed to read " << path << ". Maybe it was modified while uploading?";
+      throw std::runtime_error(message.str());
+    }
+  }
+};
+#endif
+
+}  // namespace
+
+bool File::Source::isSizeKnown() const {
+  return true;
+}
+
+size_t File::Source::getExactSize() {
+  return getSize();
+}
+
+bool File::Source::readChunks(const ChunkCallback& callback, size_t offset, size_t chunkSize) {
+  size_t size = getSize();
+  if(offset >= size) {
+    return true;
+  }
+  std::vector<char> buffer(std::min(chunkSize, size - offset));
+  while(offset < size) {
+    size_t length = read(offset, buffer.data(), std::min(buffer.size(), size - offset));
+    if(length == 0) {
+      break;
+    }
+    if(!callback(buffer.data(), length)) {
+      return false;
+    }
+    offset += length;
+  }
+  return true;
+}
+
+File::File(const std::filesystem::path& path, size_t bufferSize, bool memoryMap): bufferSize(bufferSize) {
   std::error_code error;
   if(!std::filesystem::is_regular_file(path, error)) {
     logger.log(Logger::Fatal) << "You tried to open " << path.string()
@@ -15,94 +223,99 @@ File::File(const std::filesystem::path& path) {
     quit::failedReadingFiles();
   }
 
-  std::ifstream fileStream(path, std::ios::binary | std::ios::in);
-  fileStream.seekg(0, std::ios::end);
-  long int size = fileStream.tellg();
-  if(size < 0) {
+  std::uintmax_t size = std::filesystem::file_size(path, error);
+  if(error) {
     logger.log(Logger::Fatal) << "You tried to open " << path.string()
                               << ", but reading that file failed. Actually you should not be able to get this error, because the paths are "
                                  "checked, before opening a file. Maybe you are doing something strange?";
     quit::failedReadingFiles();
   }
 
-  content.resize(static_cast<unsigned>(size));
-  fileStream.seekg(0);
-  fileStream.read(&content[0], size);
-
+#ifdef __unix__
+  if(memoryMap) {
+    source = MappedSource::map(path);
+  }
+#endif
+  // Fall back to buffered reads for files that cannot be mapped
+  if(source == nullptr) {
+    source = std::make_shared<StreamSource>(path, static_cast<size_t>(size));
+  }
   name = path.filename();
 }
 
-File::File(std::string name, std::string content): name(std::move(name)), content(std::move(content)) {}
+File::File(std::string name, std::string content)
+    : name(std::move(name)), source(std::make_shared<MemorySource>(std::move(content))), bufferSize(defaultBufferSize) {}
+
+File::File(std::string name, std::shared_ptr<Source> source, size_t bufferSize)
+    : name(std::move(name)), source(std::move(source)), bufferSize(bufferSize) {}
 
-std::string File::getName() const {
+File::File(const File& file, std::shared_ptr<Source> source)
+    : name(file.name), source(std::move(source)), bufferSize(file.bufferSize), detectedMimetype(file.detectedMimetype) {}
+
+const std::string& File::getName() const {
   return name;
 }
 
-std::string File::getContent() const {
-  return content;
+size_t File::getSize() const {
+  return source->getSize();
 }
 
-std::string File::getMimetype() const {
-  static std::map<std::string, std::string> extensionMap = {{"", "application/octet-stream"},
-                                                            {"he5", "application/x-hdf5"},
-                                                            {"hdf5", "application/x-hdf5"},
-                                                            {"h5", "application/x-hdf5"},
-                                                            {"apk", "application/vnd.android.package-archive"},
-                                                            {"jar", "application/java-archive"},
-                                                            {"css", "text/css"},
-                                                            {"csv", "text/csv"},
-                                                            {"txt", "text/plain"},
-                                                            {"vtt", "text/vtt"},
-                                                            {"htm", "text/html"},
-                                                            {"html", "text/html"},
-                                                            {"apng", "image/apng"},
-                                                            {"avif", "image/avif"},
-                                                            {"bmp", "image/bmp"},
-                                                            {"gif", "image/gif"},
-                                                            {"png", "image/png"},
-                                                            {"svg", "image/svg+xml"},
-                                                            {"webp", "image/webp"},
-                                                            {"ico", "image/x-icon"},
-                                                            {"tif", "image/tiff"},
-                                                            {"tiff", "image/tiff"},
-                                                            {"jpg", "image/jpeg"},
-                                                            {"jpeg", "image/jpeg"},
-                                                            {"mp4", "video/mp4"},
-                                                            {"mpeg", "video/mpeg"},
-                                                            {"webm", "video/webm"},
-                                                            {"mp3", "audio/mp3"},
-                                                            {"mpga", "audio/mpeg"},
-                                                            {"weba", "audio/webm"},
-                                                            {"wav", "audio/wave"},
-                                                            {"otf", "font/otf"},
-                                                            {"ttf", "font/ttf"},
-                                                            {"woff", "font/woff"},
-                                                            {"woff2", "font/woff2"},
-                                                            {"7z", "application/x-7z-compressed"},
-                                                            {"atom", "application/atom+xml"},
-                                                            {"pdf", "application/pdf"},
-                                                            {"js", "application/javascript"},
-                                                            {"mjs", "application/javascript"},
-                                                            {"json", "application/json"},
-                                                            {"rss", "application/rss+xml"},
-                                                            {"tar", "application/x-tar"},
-                                                            {"xht", "application/xhtml+xml"},
-                                                            {"xhtml", "application/xhtml+xml"},
-                                                            {"xslt", "application/xslt+xml"},
-                                                            {"xml", "application/xml"},
-                                                            {"gz", "application/gzip"},
-                                                            {"zip", "application/zip"},
-                                                            {"wasm", "application/wasm"},
-                                                            {"class", "application/java-vm"}};
+bool File::isSizeKnown() const {
+  return source->isSizeKnown();
+}
 
+size_t File::getExactSize() const {
+  return source->getExactSize();
+}
+
+size_t File::getBufferSize() const {
+  return bufferSize;
+}
+
+size_t File::read(size_t offset, char* buffer, size_t length) const {
+  return source->read(offset, buffer, length);
+}
+
+bool File::readChunks(const ChunkCallback& callback, size_t offset) const {
+  return source->readChunks(callback, offset, bufferSize);
+}
+
+std::string_view File::getContent() const {
+  return source->getContent();
+}
+
+std::span<const std::byte> File::getBytes() const {
+  std::string_view content = getContent();
+  return {reinterpret_cast<const std::byte*>(content.data()), content.size()};
+}
+
+const std::string& File::getMimetype() const {
+  std::call_once(detectedMimetype->detected, [this]() {
+    detectedMimetype->mimetype = detectMimetype();
+  });
+  return detectedMimetype->mimetype;
+}
+
+std::string File::detectMimetype() const {
   std::string extension = std::filesystem::path(name).extension();
   if(!extension.empty() && extension[0] == '.') {
     extension = extension.substr(1);
   }
+  std::string_view mimetype = mimetype::fromExtension(extension);
+
+  // Sources without a known size create their content while it is read, so only sources with a known size are sniffed
+  if(mimetype.empty() && isSizeKnown() && getSize() > 0) {
+    std::string sample(std::min(getSize(), mimetype::sampleSize), '\0');
+    try {
+      sample.resize(read(0, sample.data(), sample.size()));
+      mimetype = mimetype::fromContent(sample);
+    } catch(std::runtime_error& error) {
+      UPLOAD_LOG(Logger::Debug) << "Failed to read the start of " << name << " to detect its type. " << error.what() << '\n';
+    }
+  }
 
-  if(extensionMap.contains(extension)) {
-    return extensionMap[extension];
-  } else {
+  if(mimetype.empty()) {
     return "application/octet-stream";
   }
+  return std::string(mimetype);
 }
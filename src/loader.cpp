@@ -1,38 +1,55 @@
 #include "loader.hpp"
 
-#include <zip_file.hpp>
-
-Loader::Loader(const Settings& settings): settings(settings), threadCounter(0) {
-  loadFilesFromSettings();
+#include "directorywalker.hpp"
+#include "directorywatcher.hpp"
+#include "recordreader.hpp"
+#include "tararchive.hpp"
+#include "ziparchive.hpp"
+
+Loader::Loader(const Settings& settings): unprocessedPaths(maxUnprocessedPaths), settings(settings) {
+  // The files are loaded in a thread, because the queue may be full before all of them are loaded
+  startProducerThread([this]() {
+    loadFilesFromSettings();
+  });
 }
 
-Loader::~Loader() = default;
+Loader::~Loader() {
+  unprocessedPaths.close();
+}
 
 void Loader::loadFilesFromSettings() {
   if(settings.getMode() == Settings::Mode::Archive || settings.getMode() == Settings::Mode::Individual) {
+    PathBatch batch;
     for(const std::string& fileName : settings.getFiles()) {
       if(fileName == "-") {
         startStreamThread("-");
       } else {
-        loadPath(fileName);
+        loadPath(fileName, batch);
+      }
+      if(batch.size() >= maxBatchSize) {
+        submitBatch(batch);
       }
     }
+    submitBatch(batch);
+    for(const std::string& directory : settings.getWatchDirectories()) {
+      startWatchThread(directory);
+    }
   }
 }
 
-void Loader::loadPath(const std::filesystem::path& path) {
+void Loader::loadPath(const std::filesystem::path& path, PathBatch& batch) {
   try {
     std::filesystem::file_status fileStatus = ensureFileStatus(path);
 
     switch(fileStatus.type()) {
       case std::filesystem::file_type::directory:
-        loadDirectory(path);
+        loadDirectory(path, batch);
         break;
       case std::filesystem::file_type::regular:
-        loadRegularFile(path);
+        loadRegularFile(path, batch);
         break;
       case std::filesystem::file_type::symlink:
-        loadSymlink(path);
+        loadSymlink(path, batch);
         break;
       case std::filesystem::file_type::character:
         loadCharacterSpecialFile(path);
@@ -72,13 +89,9 @@ void Loader::loadPath(const std::filesystem::path& path) {
   }
 }
 
-void Loader::loadRegularFile(const std::filesystem::path& path) {
+void Loader::loadRegularFile(const std::filesystem::path& path, PathBatch& batch) {
   if(isReadable(path)) {
-    {
-      std::unique_lock<std::mutex> lock(unprocessedFilesAccessMutex);
-      unprocessedFiles.push(path);
-    }
-    unprocessedFilesConditionVariable.notify_one();
+    batch.push_back(path);
   } else {
     logger.log(Logger::LoadFatal) << "You do not have the permission to access the file " << path
                                   << " . Contact your system administrator about that, or something. You can give everyone read "
@@ -90,7 +103,7 @@ void Loader::loadRegularFile(const std::filesystem::path& path) {
   }
 }
 
-void Loader::loadSymlink(std::filesystem::path path) {
+void Loader::loadSymlink(std::filesystem::path path, PathBatch& batch) {
   constexpr int maxRedirects = 16;
   int redirects = 0;
   try {
@@ -116,7 +129,7 @@ void Loader::loadSymlink(std::filesystem::path path) {
         }
       } catch(const std::filesystem::filesystem_error& error) {
         logger.log(Logger::LoadFatal) << "You tried to upload the symlink " << path << ", but it cannot be followed." << '\n';
-        logger.log(Logger::Debug) << error.what() << '\n';
+        UPLOAD_LOG(Logger::Debug) << error.what() << '\n';
         if(!settings.getContinueLoading()) {
           quit::failedReadingFiles();
         }
@@ -130,16 +143,12 @@ void Loader::loadSymlink(std::filesystem::path path) {
     }
     return;
   }
-  loadPath(path);
+  loadPath(path, batch);
 }
 
-void Loader::loadDirectory(const std::filesystem::path& path) {
+void Loader::loadDirectory(const std::filesystem::path& path, PathBatch& batch) {
   if(isReadable(path)) {
-    {
-      std::unique_lock<std::mutex> lock(unprocessedFilesAccessMutex);
-      unprocessedFiles.push(path);
-    }
-    unprocessedFilesConditionVariable.notify_one();
+    batch.push_back(path);
   } else {
     logger.log(Logger::LoadFatal) << "You do not have the permission to access the directory " << path
                                   << " . Contact your system administrator about that, or something. You can give everyone read "
@@ -176,44 +185,70 @@ void Loader::loadCharacterSpecialFile(const std::filesystem::path& path) {
 }
 
 void Loader::startStreamThread(const std::filesystem::path& path) {
-  threads.emplace_back([this, path]() {
-    {
-      std::unique_lock<std::mutex> lock(unprocessedFilesAccessMutex);
-      ++threadCounter;
-    }
-    std::istream* stream;
-    if(path == "-") {
-      stream = &std::cin;
-    } else {
-      stream = new std::ifstream(path);
-    }
-    while(stream->good()) {
-      static constexpr int maxPathSize = 512;
-      char buffer[maxPathSize];
-      stream->getline(buffer, maxPathSize);
-      logger.log(Logger::Debug) << "After  Good: " << stream->good() << "Bad: " << stream->bad() << "fail: " << stream->fail()
-                                << "eof: " << stream->eof() << '\n';
-      if(!stream->fail()) {
-        if(buffer[0] != 0) {
-          loadPath(std::string(buffer));
+  startProducerThread([this, path]() {
+    try {
+      RecordReader reader(path, settings.getNullSeparated() ? '\0' : '\n', settings.getBufferSize());
+      std::vector<std::string> fileNames;
+      PathBatch batch;
+      bool reading = true;
+      while(reading) {
+        // Everything that was available is loaded at once
+        reading = reader.read(fileNames);
+        for(const std::string& fileName : fileNames) {
+          loadPath(fileName, batch);
         }
-      } else if(!stream->eof()) {
-        if(buffer[0] != 0) {
-          logger.log(Logger::Info) << "Filename received from stream is longer than 512 characters. This is currently not supported." << '\n';
-          while(stream->good() && stream->get() != '\n') {
+        fileNames.clear();
+        submitBatch(batch);
+      }
+    } catch(const std::runtime_error& error) {
+      logger.log(Logger::LoadFatal) << error.what() << '\n';
+      if(!settings.getContinueLoading()) {
+        quit::failedReadingFiles();
+      }
+    }
+    UPLOAD_LOG(Logger::Debug) << "Stream finished" << '\n';
+  });
+}
+
+void Loader::startWatchThread(const std::filesystem::path& directory) {
+  startProducerThread([this, directory]() {
+    try {
+      DirectoryWatcher watcher(directory, std::chrono::milliseconds(settings.getWatchDelay()));
+      logger.log(Logger::Info) << "Watching " << directory << " for new files." << '\n';
+      PathBatch batch;
+      while(true) {
+        for(const std::filesystem::path& path : watcher.wait()) {
+          // Temporary files may be renamed or removed during the delay
+          std::error_code error;
+          if(std::filesystem::exists(path, error)) {
+            loadPath(path, batch);
           }
         }
+        submitBatch(batch);
+      }
+    } catch(const std::runtime_error& error) {
+      logger.log(Logger::LoadFatal) << error.what() << '\n';
+      if(!settings.getContinueLoading()) {
+        quit::failedReadingFiles();
       }
     }
-    if(stream != &std::cin) {
-      delete stream;
-    }
-    {
-      std::unique_lock<std::mutex> lock(unprocessedFilesAccessMutex);
-      --threadCounter;
-    }
-    unprocessedFilesConditionVariable.notify_one();
-    logger.log(Logger::Debug) << "Stream finished" << '\n';
+  });
+}
+
+void Loader::submitBatch(PathBatch& batch) {
+  if(!batch.empty()) {
+    unprocessedPaths.pushAll(batch);
+    batch.clear();
+  }
+}
+
+void Loader::startProducerThread(std::function<void()> function) {
+  // The producer is added before the thread starts, so the consumer cannot miss it
+  unprocessedPaths.addProducer();
+  std::unique_lock<std::mutex> lock(threadsMutex);
+  threads.emplace_back([this, function = std::move(function)]() {
+    function();
+    unprocessedPaths.removeProducer();
   });
 }
 
@@ -244,7 +279,7 @@ std::filesystem::file_status Loader::ensureFileStatus(const std::filesystem::pat
   } catch(const std::filesystem::filesystem_error& error) {
     std::stringstream message;
     message << "Failed to get information about the file " << path << ". Maybe the path is not formatted correctly?" << '\n';
-    logger.log(Logger::Debug) << error.what() << '\n';
+    UPLOAD_LOG(Logger::Debug) << error.what() << '\n';
     throw std::runtime_error(message.str());
   }
 }
@@ -259,10 +294,9 @@ bool Loader::isReadable(const std::filesystem::path& path) {
   return true;
 }
 
-// TODO rewrite this method
 std::shared_ptr<File> Loader::createArchive(const std::vector<std::filesystem::path>& files, const std::string& name, bool directoryCreation) {
-  miniz_cpp::zip_file file;
-  logger.log(Logger::Debug) << "Creating archive " << name << ". " << '\n';
+  std::vector<ArchiveEntry> entries;
+  UPLOAD_LOG(Logger::Debug) << "Creating archive " << name << ". " << '\n';
   for(const std::filesystem::path& path : files) {
     if(std::filesystem::is_directory(path)) {
       std::error_code error;
@@ -276,109 +310,99 @@ std::shared_ptr<File> Loader::createArchive(const std::vector<std::filesystem::p
         continue;
       }
 
-      std::filesystem::path basePath = canonicalPath;
-      if(directoryCreation) {
-        basePath.remove_filename();
-      }
-
-      for(auto& p : std::filesystem::recursive_directory_iterator(canonicalPath)) {
-        // Absolute path in filesystem
-        try {
-          std::filesystem::file_status status = ensureFileStatus(p.path());
-          if(status.type() != std::filesystem::file_type::regular && status.type() != std::filesystem::file_type::directory) {
-            logger.log(Logger::LoadFatal) << "Only regular files and directories can be archived. You tried to archive " << path
-                                          << ", which is neither." << '\n';
-            if(!settings.getContinueLoading()) {
-              quit::failedReadingFiles();
-            }
-            logger.log(Logger::LoadFatal) << "Ignoring that and continuing." << '\n';
-            continue;
-          }
-          std::filesystem::path realPath = std::filesystem::canonical(p.path(), error);
-          if(error) {
-            logger.log(Logger::Fatal) << "Failed to create canonical path of " << path << " . This should not happen." << '\n';
-            if(!settings.getContinueLoading()) {
-              quit::failedReadingFiles();
-            }
-            logger.log(Logger::LoadFatal) << "Ignoring that and continuing." << '\n';
-            continue;
-          }
-
-          // Path in archive
-          std::filesystem::path resultPath = std::filesystem::relative(realPath, basePath);
-
-          if(std::filesystem::is_directory(realPath)) {
-            std::string resultDirPath = resultPath.string() + "/";
-            file.writestr(resultDirPath, "");
-          } else {
-            File f(realPath);
-            file.writestr(resultPath, f.getContent());
-          }
-        } catch(const std::runtime_error& error) {
-          logger.log(Logger::LoadFatal) << error.what() << '\n';
+      try {
+        // With directory creation, the entries are put into a directory with the name of the directory
+        std::string prefix = directoryCreation ? canonicalPath.filename().string() : "";
+        DirectoryWalker::Result result = DirectoryWalker().walk(canonicalPath, prefix);
+        for(const std::string& message : result.errors) {
+          logger.log(Logger::LoadFatal) << message << '\n';
           if(!settings.getContinueLoading()) {
             quit::failedReadingFiles();
           }
-          continue;
+          logger.log(Logger::LoadFatal) << "Ignoring that and continuing." << '\n';
+        }
+        std::move(result.entries.begin(), result.entries.end(), std::back_inserter(entries));
+      } catch(const std::runtime_error& error) {
+        logger.log(Logger::LoadFatal) << error.what() << '\n';
+        if(!settings.getContinueLoading()) {
+          quit::failedReadingFiles();
         }
+        continue;
       }
 
     } else {
-      File f(path);
-      file.writestr(f.getName(), f.getContent());
+      try {
+        entries.push_back(ArchiveEntry::fromPath(path.filename().string(), path));
+      } catch(const std::runtime_error& error) {
+        logger.log(Logger::LoadFatal) << error.what() << '\n';
+        if(!settings.getContinueLoading()) {
+          quit::failedReadingFiles();
+        }
+      }
     }
   }
 
-  std::stringstream archiveStream;
-  file.save(archiveStream);
-
-  return std::make_shared<File>(name, archiveStream.str());
-}
-
-std::filesystem::path Loader::getUnprocessedPath() {
-  // Read until a real path is read
-  std::unique_lock<std::mutex> lock(unprocessedFilesAccessMutex);
-  unprocessedFilesConditionVariable.wait(lock, [this]() {
-    return (!unprocessedFiles.empty()) || (threadCounter == 0);
-  });
-  if(!unprocessedFiles.empty()) {
-    std::filesystem::path path = unprocessedFiles.front();
-    unprocessedFiles.pop();
-    return path;
-  } else if(threadCounter == 0) {
-    throw std::runtime_error("No more files");
+  // The archive is generated while it is uploaded
+  std::shared_ptr<ArchiveSource> archive;
+  switch(settings.getArchiveType()) {
+    case Settings::ArchiveType::Tar:
+      archive = std::make_shared<TarArchive>(std::move(entries), settings.getBufferSize(), settings.getMemoryMap());
+      break;
+    case Settings::ArchiveType::TarGz:
+      archive = std::make_shared<TarArchive>(std::move(entries),
+                                             settings.getBufferSize(),
+                                             settings.getMemoryMap(),
+                                             TarArchive::Compression::Gzip,
+                                             settings.getCompressionThreads(),
+                                             settings.getCompressionLevel());
+      break;
+    case Settings::ArchiveType::TarZst:
+      archive = std::make_shared<TarArchive>(std::move(entries),
+                                             settings.getBufferSize(),
+                                             settings.getMemoryMap(),
+                                             TarArchive::Compression::Zstd,
+                                             settings.getCompressionThreads(),
+                                             settings.getCompressionLevel());
+      break;
+    case Settings::ArchiveType::Zip:
+    default:
+      archive = std::make_shared<ZipArchive>(std::move(entries),
+                                             settings.getBufferSize(),
+                                             settings.getMemoryMap(),
+                                             settings.getCompressionThreads(),
+                                             settings.getCompressionLevel());
+      break;
   }
+  return std::make_shared<File>(name, archive, settings.getBufferSize());
+}
 
-  logger.log(Logger::Debug) << "Condition variable stopped waiting, but no condition was fulfilled. This should not happen." << '\n';
-  throw std::runtime_error("Something went wrong");
+std::optional<std::filesystem::path> Loader::getUnprocessedPath() {
+  // Waits until a path is available or all producers are finished
+  return unprocessedPaths.pop();
 }
 
 std::shared_ptr<File> Loader::getNextFile() {
   switch(settings.getMode()) {
     default:
-      logger.log(Logger::Topic::Debug) << "Unknown mode.";
+      UPLOAD_LOG(Logger::Topic::Debug) << "Unknown mode.";
     case Settings::Mode::List:
       break;
     case Settings::Mode::Individual: {
-      try {
-        std::filesystem::path path = getUnprocessedPath();
-        if(std::filesystem::is_directory(path)) {
-          return createArchive(std::vector<std::filesystem::path>{path}, path.filename(), settings.getDirectoryArchive());
-        } else {
-          return std::make_shared<File>(path);
-        }
-      } catch(const std::runtime_error& error) {
-        logger.log(Logger::Debug) << "All files loaded.";
+      std::optional<std::filesystem::path> path = getUnprocessedPath();
+      if(!path) {
+        UPLOAD_LOG(Logger::Debug) << "All files loaded." << '\n';
         return std::shared_ptr<File>(nullptr);
       }
+      if(std::filesystem::is_directory(*path)) {
+        return createArchive(std::vector<std::filesystem::path>{*path}, path->filename(), settings.getDirectoryArchive());
+      } else {
+        return std::make_shared<File>(*path, settings.getBufferSize(), settings.getMemoryMap());
+      }
     }
     case Settings::Mode::Archive: {
       std::vector<std::filesystem::path> allPaths;
-      try {
-        while(true) {
-          allPaths.push_back(getUnprocessedPath());
-        }
-      } catch(const std::runtime_error& error) {
+      while(std::optional<std::filesystem::path> path = getUnprocessedPath()) {
+        allPaths.push_back(std::move(*path));
       }
 
       if(allPaths.empty()) {
@@ -1,18 +1,20 @@
 #ifndef LOADER_HPP
 #define LOADER_HPP
 
-#include <condition_variable>
 #include <cstddef>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
-#include <queue>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "file.hpp"
 #include "logger.hpp"
+#include "mpmcqueue.hpp"
 #include "settings.hpp"
 
 #ifdef __unix__
@@ -45,17 +47,21 @@ class Loader {
     std::shared_ptr<File> file;
   };
 
-  std::vector<std::jthread> threads;
-  int threadCounter;
-
-  // The unprocessed files mutex should be locked, when unprocessedFiles or threadCounter gets modified.
-  std::condition_variable unprocessedFilesConditionVariable;
-  std::mutex unprocessedFilesAccessMutex;
+  // Paths that are read from the settings and from streams are passed through the queue.
+  // The settings thread and every stream thread are producers. Their paths are loaded, when all producers are finished.
+  static constexpr size_t maxUnprocessedPaths = 1024;
+  // Paths are collected in batches, before they are added to the queue
+  static constexpr size_t maxBatchSize = 256;
+  using PathBatch = std::vector<std::filesystem::path>;
 
   // All files/directories that are not yet loaded
-  std::queue<std::filesystem::path> unprocessedFiles;
+  MpmcQueue<std::filesystem::path> unprocessedPaths;
   Settings settings;
 
+  // Lock the mutex, when starting a thread
+  std::mutex threadsMutex;
+  std::vector<std::jthread> threads;
+
  public:
   explicit Loader(const Settings& settings);
   ~Loader();
@@ -67,17 +73,23 @@ class Loader {
  private:
   void loadFilesFromSettings();
 
-  // Loads a path into this object
-  void loadPath(const std::filesystem::path& path);
-  void loadRegularFile(const std::filesystem::path& path);
-  void loadSymlink(std::filesystem::path path);
-  void loadDirectory(const std::filesystem::path& path);
+  // Loads a path into batch. The batch has to be submitted afterwards
+  void loadPath(const std::filesystem::path& path, PathBatch& batch);
+  void loadRegularFile(const std::filesystem::path& path, PathBatch& batch);
+  void loadSymlink(std::filesystem::path path, PathBatch& batch);
+  void loadDirectory(const std::filesystem::path& path, PathBatch& batch);
   void loadFifoFile(const std::filesystem::path& path);
   void loadCharacterSpecialFile(const std::filesystem::path& path);
 
   // Starts a thread that reads new filenames from the file at
   // Undefined behaviour, if path is not a readable file
   void startStreamThread(const std::filesystem::path& path);
+  // Starts a thread that loads the files, that are written to directory, until upload is stopped
+  void startWatchThread(const std::filesystem::path& directory);
+  // Add the loaded paths to the unprocessed paths and clear batch
+  void submitBatch(PathBatch& batch);
+  // Starts a thread that runs function as producer of unprocessed paths
+  void startProducerThread(std::function<void()> function);
 
   // Ensure that a path exists and information about it can be optained
   static std::filesystem::file_status ensureFileStatus(const std::filesystem::path& path);
@@ -86,8 +98,8 @@ class Loader {
   static bool isReadable(const std::filesystem::path& status);
 
   // Wait until the next path is available and return it.
-  // Throws std::runtime_error, when all paths have been read
-  std::filesystem::path getUnprocessedPath();
+  // Returns std::nullopt, when all paths have been read
+  std::optional<std::filesystem::path> getUnprocessedPath();
 
   std::shared_ptr<File> createArchive(const std::vector<std::filesystem::path>& files, const std::string& name, bool directoryCreation);
 };
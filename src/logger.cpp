@@ -1,24 +1,70 @@
 #include "logger.hpp"
 
+#include <streambuf>
+
 Logger logger;
 
-Logger::Logger() {
-  nullstream = new std::ofstream();
-  nullstream->setstate(std::ios_base::badbit);
+namespace {
 
-  topicStream[Topic::Fatal] = &std::cout;
-  topicStream[Topic::Print] = &std::cout;
-  topicStream[Topic::Url] = &std::cout;
-  topicStream[Topic::Info] = nullptr;
-  topicStream[Topic::Debug] = nullptr;
+// Collects the messages of one thread. Messages are only removed from the end, so nested records keep their parts apart.
+class MessageBuffer: public std::streambuf {
+ public:
+  std::string content;
+  // Set by std::flush and std::endl
+  bool flushRequested = false;
+
+ protected:
+  int_type overflow(int_type character) override {
+    if(!traits_type::eq_int_type(character, traits_type::eof())) {
+      content.push_back(traits_type::to_char_type(character));
+    }
+    return traits_type::not_eof(character);
+  }
+
+  std::streamsize xsputn(const char* data, std::streamsize length) override {
+    content.append(data, static_cast<size_t>(length));
+    return length;
+  }
+
+  int sync() override {
+    flushRequested = true;
+    return 0;
+  }
+};
+
+struct ThreadBuffer {
+  MessageBuffer buffer;
+  std::ostream stream{&buffer};
+};
+
+ThreadBuffer& getThreadBuffer() {
+  thread_local ThreadBuffer threadBuffer;
+  return threadBuffer;
 }
 
-Logger::~Logger() {
-  delete nullstream;
+}  // namespace
+
+Logger::Record::Record(Logger* logger, std::ostream* stream)
+    : logger(logger), stream(stream), start(stream != nullptr ? getThreadBuffer().buffer.content.size() : 0) {}
+
+Logger::Record::~Record() {
+  if(stream != nullptr) {
+    logger->write(*stream, start);
+  }
+}
+
+Logger::Record& Logger::Record::operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+  if(stream != nullptr) {
+    manipulator(getBuffer());
+  }
+  return *this;
 }
 
-bool Logger::getTopicState(Topic topic) {
-  return (topicStream[topic] != nullptr && topicStream[topic] != nullstream);
+Logger::Logger() {
+  // Errors never go to stdout, so it only contains urls or JSON records
+  topicStream[Topic::Fatal] = &std::clog;
+  topicStream[Topic::Print] = &std::cout;
+  topicStream[Topic::Url] = &std::cout;
 }
 
 void Logger::setTopicStream(Topic topic, std::ostream* stream) {
@@ -33,13 +79,23 @@ void Logger::log(Topic topic, const std::string& message) {
   log(topic) << message;
 }
 
-std::ostream& Logger::log(Topic topic) {
-  if(topicStream[topic] == nullptr) {
-    return *nullstream;
-  }
-  return *topicStream[topic];
+Logger::Record Logger::debug() {
+  return log(Topic::Debug);
 }
 
-std::ostream& Logger::debug() {
-  return log(Topic::Debug);
+std::ostream& Logger::getBuffer() {
+  return getThreadBuffer().stream;
+}
+
+void Logger::write(std::ostream& stream, size_t start) {
+  MessageBuffer& buffer = getThreadBuffer().buffer;
+  if(start < buffer.content.size()) {
+    std::unique_lock<std::mutex> lock(streamMutex);
+    stream.write(buffer.content.data() + start, static_cast<std::streamsize>(buffer.content.size() - start));
+    if(buffer.flushRequested) {
+      stream.flush();
+    }
+  }
+  buffer.content.resize(start);
+  buffer.flushRequested = false;
 }
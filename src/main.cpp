@@ -3,6 +3,7 @@
 #include "file.hpp"
 #include "loader.hpp"
 #include "logger.hpp"
+#include "pipeline.hpp"
 #include "settings.hpp"
 #include "uploader.hpp"
 
@@ -10,14 +11,11 @@ int main(int argc, char** argv) {
   Settings settings(argc, argv);
 
   Loader loader(settings);
-  Uploader uploader(settings);
-
-  for(const File& file : loader) {
-    try {
-      logger.log(Logger::Url) << uploader.uploadFile(file) << std::endl;
-    } catch(const std::runtime_error& error) {
-      logger.log(Logger::Info) << error.what() << '\n';
-    }
+  {
+    // The uploader waits for its cancelled uploads, when it is destroyed
+    Uploader uploader(settings);
+    Pipeline pipeline(settings, loader, uploader);
+    pipeline.run();
   }
 
   // Exit, because there is no need to wait for other threads anymore.
@@ -0,0 +1,218 @@
+#include "mimetype.hpp"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+
+using namespace std::string_view_literals;
+
+struct Extension {
+  std::string_view extension;
+  std::string_view mimetype;
+};
+
+// The extensions have to be lowercase
+constexpr auto extensions = std::to_array<Extension>({{"he5", "application/x-hdf5"},
+                                                      {"hdf5", "application/x-hdf5"},
+                                                      {"h5", "application/x-hdf5"},
+                                                      {"apk", "application/vnd.android.package-archive"},
+                                                      {"jar", "application/java-archive"},
+                                                      {"css", "text/css"},
+                                                      {"csv", "text/csv"},
+                                                      {"txt", "text/plain"},
+                                                      {"vtt", "text/vtt"},
+                                                      {"htm", "text/html"},
+                                                      {"html", "text/html"},
+                                                      {"apng", "image/apng"},
+                                                      {"avif", "image/avif"},
+                                                      {"bmp", "image/bmp"},
+                                                      {"gif", "image/gif"},
+                                                      {"png", "image/png"},
+                                                      {"svg", "image/svg+xml"},
+                                                      {"webp", "image/webp"},
+                                                      {"ico", "image/x-icon"},
+                                                      {"tif", "image/tiff"},
+                                                      {"tiff", "image/tiff"},
+                                                      {"jpg", "image/jpeg"},
+                                                      {"jpeg", "image/jpeg"},
+                                                      {"mp4", "video/mp4"},
+                                                      {"mpeg", "video/mpeg"},
+                                                      {"webm", "video/webm"},
+                                                      {"mp3", "audio/mp3"},
+                                                      {"mpga", "audio/mpeg"},
+                                                      {"weba", "audio/webm"},
+                                                      {"wav", "audio/wave"},
+                                                      {"otf", "font/otf"},
+                                                      {"ttf", "font/ttf"},
+                                                      {"woff", "font/woff"},
+                                                      {"woff2", "font/woff2"},
+                                                      {"7z", "application/x-7z-compressed"},
+                                                      {"atom", "application/atom+xml"},
+                                                      {"pdf", "application/pdf"},
+                                                      {"js", "application/javascript"},
+                                                      {"mjs", "application/javascript"},
+                                                      {"json", "application/json"},
+                                                      {"rss", "application/rss+xml"},
+                                                      {"tar", "application/x-tar"},
+                                                      {"xht", "application/xhtml+xml"},
+                                                      {"xhtml", "application/xhtml+xml"},
+                                                      {"xslt", "application/xslt+xml"},
+                                                      {"xml", "application/xml"},
+                                                      {"gz", "application/gzip"},
+                                                      {"tgz", "application/gzip"},
+                                                      {"zst", "application/zstd"},
+                                                      {"zip", "application/zip"},
+                                                      {"wasm", "application/wasm"},
+                                                      {"class", "application/java-vm"}});
+
+struct Signature {
+  size_t offset;
+  std::string_view magic;
+  std::string_view mimetype;
+};
+
+// If signatures overlap, the more specific one has to come first. Octal escapes are used, where a hexadecimal escape would be followed
+// by a hexadecimal digit
+constexpr auto signatures = std::to_array<Signature>({{0, "\177ELF"sv, "application/x-executable"},
+                                                      {0, "\xca\xfe\xba\xbe"sv, "application/java-vm"},
+                                                      {0, "\x89HDF\r\n\x1a\n"sv, "application/x-hdf5"},
+                                                      {0, "PK\x03\x04"sv, "application/zip"},
+                                                      {0, "\x1f\x8b"sv, "application/gzip"},
+                                                      {0, "\x28\xb5\x2f\xfd"sv, "application/zstd"},
+                                                      {0, "7z\xbc\xaf\x27\x1c"sv, "application/x-7z-compressed"},
+                                                      {0, "\3757zXZ\0"sv, "application/x-xz"},
+                                                      {0, "BZh"sv, "application/x-bzip2"},
+                                                      {257, "ustar"sv, "application/x-tar"},
+                                                      {0, "\0asm"sv, "application/wasm"},
+                                                      {0, "%PDF-"sv, "application/pdf"},
+                                                      {0, "<?xml "sv, "application/xml"},
+                                                      {0, "\x89PNG\r\n\x1a\n"sv, "image/png"},
+                                                      {0, "\xff\xd8\xff"sv, "image/jpeg"},
+                                                      {0, "GIF87a"sv, "image/gif"},
+                                                      {0, "GIF89a"sv, "image/gif"},
+                                                      {4, "ftypavif"sv, "image/avif"},
+                                                      {4, "ftyp"sv, "video/mp4"},
+                                                      {0, "\032E\xdf\xa3"sv, "video/webm"},
+                                                      {0, "ID3"sv, "audio/mp3"},
+                                                      {0, "OTTO"sv, "font/otf"},
+                                                      {0, "\0\1\0\0\0"sv, "font/ttf"},
+                                                      {0, "wOFF"sv, "font/woff"},
+                                                      {0, "wOF2"sv, "font/woff2"}});
+
+constexpr char toLower(char character) {
+  return character >= 'A' && character <= 'Z' ? static_cast<char>(character - 'A' + 'a') : character;
+}
+
+constexpr uint32_t hashExtension(std::string_view extension, uint32_t seed) {
+  // FNV-1a with a final mix, so the low bits depend on all characters
+  uint32_t hash = 2166136261u ^ seed;
+  for(char character : extension) {
+    hash ^= static_cast<unsigned char>(toLower(character));
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 15;
+  hash *= 0x2c1b3c6du;
+  hash ^= hash >> 12;
+  return hash;
+}
+
+// A perfect hash table of the extensions. The seed is searched at compile time, so that every extension gets its own slot. A lookup is
+// one hash and one comparison.
+class ExtensionTable {
+  static constexpr size_t slotCount = 256;
+  uint32_t seed = 0;
+  // The index of the extension in a slot plus one. Empty slots are 0
+  std::array<uint8_t, slotCount> slots{};
+
+ public:
+  static consteval ExtensionTable build() {
+    static_assert(extensions.size() < 255, "The slots cannot hold that many extensions");
+    for(uint32_t seed = 0; seed < 100000; seed++) {
+      ExtensionTable table;
+      table.seed = seed;
+      bool collision = false;
+      for(size_t i = 0; i < extensions.size() && !collision; i++) {
+        uint8_t& slot = table.slots[hashExtension(extensions[i].extension, seed) % slotCount];
+        collision = slot != 0;
+        slot = static_cast<uint8_t>(i + 1);
+      }
+      if(!collision) {
+        return table;
+      }
+    }
+    throw std::logic_error("There is no perfect hash for the extensions");
+  }
+
+  [[nodiscard]] constexpr std::string_view find(std::string_view extension) const {
+    uint8_t slot = slots[hashExtension(extension, seed) % slotCount];
+    if(slot == 0) {
+      return {};
+    }
+    const Extension& candidate = extensions[slot - 1];
+    if(candidate.extension.size() != extension.size()) {
+      return {};
+    }
+    for(size_t i = 0; i < extension.size(); i++) {
+      if(toLower(extension[i]) != candidate.extension[i]) {
+        return {};
+      }
+    }
+    return candidate.mimetype;
+  }
+};
+
+constexpr ExtensionTable extensionTable = ExtensionTable::build();
+
+static_assert(extensionTable.find("PNG") == "image/png");
+static_assert(extensionTable.find("woff2") == "font/woff2");
+static_assert(extensionTable.find("").empty());
+
+// "MZ" alone is too short to tell executables from text, so the PE header has to be in the sample, where the DOS header points to
+bool isPortableExecutable(std::string_view sample) {
+  constexpr size_t peOffsetPosition = 0x3c;
+  if(sample.size() < peOffsetPosition + 4 || !sample.starts_with("MZ")) {
+    return false;
+  }
+  size_t peOffset = 0;
+  for(size_t i = 0; i < 4; i++) {
+    peOffset |= static_cast<size_t>(static_cast<unsigned char>(sample[peOffsetPosition + i])) << (8 * i);
+  }
+  return peOffset < sample.size() && sample.substr(peOffset, 4) == "PE\0\0"sv;
+}
+
+bool isText(std::string_view sample) {
+  for(char character : sample) {
+    auto byte = static_cast<unsigned char>(character);
+    if((byte < 0x20 && byte != '\t' && byte != '\n' && byte != '\v' && byte != '\f' && byte != '\r' && byte != 0x1b) || byte == 0x7f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace mimetype {
+
+std::string_view fromExtension(std::string_view extension) {
+  return extensionTable.find(extension);
+}
+
+std::string_view fromContent(std::string_view sample) {
+  for(const Signature& signature : signatures) {
+    if(sample.size() >= signature.offset + signature.magic.size() && sample.substr(signature.offset, signature.magic.size()) == signature.magic) {
+      return signature.mimetype;
+    }
+  }
+  if(isPortableExecutable(sample)) {
+    return "application/x-dosexec";
+  }
+  if(!sample.empty() && isText(sample)) {
+    return "text/plain";
+  }
+  return {};
+}
+
+}  // namespace mimetype
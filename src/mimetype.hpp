@@ -0,0 +1,21 @@
+#ifndef MIMETYPE_HPP
+#define MIMETYPE_HPP
+
+#include <cstddef>
+#include <string_view>
+
+namespace mimetype {
+
+// The number of bytes at the start of a file, that are used to detect its type by content
+constexpr size_t sampleSize = 512;
+
+// Get the mimetype for an extension without the leading dot. The case is ignored. Returns an empty view, if the extension is unknown
+std::string_view fromExtension(std::string_view extension);
+
+// Detect the mimetype from the magic bytes at the start of a file. Content without a known signature is text/plain, if it does not
+// contain control characters. Returns an empty view, if the type could not be detected
+std::string_view fromContent(std::string_view sample);
+
+}  // namespace mimetype
+
+#endif
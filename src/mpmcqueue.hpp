@@ -0,0 +1,206 @@
+#ifndef MPMC_QUEUE_HPP
+#define MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// A bounded lock-free queue for multiple producers and consumers, based on the array queue by Dmitry Vyukov.
+// Every cell has a sequence number, that tells producers and consumers whose turn it is, so they only synchronize on one cell.
+// Producers wait while the queue is full. Consumers wait while the queue is empty and there are producers left. Waiting uses
+// atomic wait and notify instead of locks.
+template<typename T>
+class MpmcQueue {
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T element;
+  };
+
+  static constexpr size_t cacheLineSize = 64;
+
+  size_t mask;
+  std::unique_ptr<Cell[]> cells;
+  // The positions are on their own cache lines, so producers and consumers do not slow each other down
+  alignas(cacheLineSize) std::atomic<size_t> pushPosition;
+  alignas(cacheLineSize) std::atomic<size_t> popPosition;
+  // Incremented after every push and pop. Waiting threads wait for these to change
+  alignas(cacheLineSize) std::atomic<uint32_t> pushCount;
+  std::atomic<uint32_t> popCount;
+  std::atomic<size_t> producers;
+  std::atomic<bool> closed;
+
+ public:
+  // The capacity is rounded up to a power of two
+  explicit MpmcQueue(size_t capacity);
+  MpmcQueue(const MpmcQueue&) = delete;
+  // Add element, if the queue is not full. Element is only moved from, if true is returned
+  bool tryPush(T& element);
+  // Wait until there is space in the queue and add element. Returns false, if the queue is closed
+  bool push(T element);
+  // Wait until all elements are added. Consumers are only woken once, unless the queue gets full.
+  // Returns the number of added elements, which is smaller than the number of elements, if the queue is closed
+  size_t pushAll(std::vector<T>& elements);
+  // Remove an element, if the queue is not empty
+  std::optional<T> tryPop();
+  // Wait until an element is available and remove it. Returns std::nullopt, if there are no producers left and the queue is empty,
+  // or if the queue is closed
+  std::optional<T> pop();
+  // Register a producer. Consumers wait for elements until every producer is removed
+  void addProducer();
+  void removeProducer();
+  // Stop waiting producers and consumers. Remaining elements are discarded
+  void close();
+
+ private:
+  void notifyConsumers();
+};
+
+template<typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity)
+    : mask(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1),
+      cells(new Cell[mask + 1]),
+      pushPosition(0),
+      popPosition(0),
+      pushCount(0),
+      popCount(0),
+      producers(0),
+      closed(false) {
+  for(size_t i = 0; i <= mask; i++) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template<typename T>
+bool MpmcQueue<T>::tryPush(T& element) {
+  size_t position = pushPosition.load(std::memory_order_relaxed);
+  while(true) {
+    Cell& cell = cells[position & mask];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+    if(difference == 0) {
+      // The cell is free for this position
+      if(pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        cell.element = std::move(element);
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if(difference < 0) {
+      // The cell still contains the element from one round earlier
+      return false;
+    } else {
+      position = pushPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template<typename T>
+bool MpmcQueue<T>::push(T element) {
+  while(!closed.load(std::memory_order_acquire)) {
+    uint32_t pops = popCount.load(std::memory_order_acquire);
+    if(tryPush(element)) {
+      notifyConsumers();
+      return true;
+    }
+    popCount.wait(pops, std::memory_order_acquire);
+  }
+  return false;
+}
+
+template<typename T>
+size_t MpmcQueue<T>::pushAll(std::vector<T>& elements) {
+  size_t pushed = 0;
+  bool notified = true;
+  while(pushed < elements.size() && !closed.load(std::memory_order_acquire)) {
+    uint32_t pops = popCount.load(std::memory_order_acquire);
+    if(tryPush(elements[pushed])) {
+      pushed++;
+      notified = false;
+      continue;
+    }
+    // The consumers have to take some elements, before there is space again
+    if(!notified) {
+      notifyConsumers();
+      notified = true;
+    }
+    popCount.wait(pops, std::memory_order_acquire);
+  }
+  if(!notified) {
+    notifyConsumers();
+  }
+  return pushed;
+}
+
+template<typename T>
+std::optional<T> MpmcQueue<T>::tryPop() {
+  size_t position = popPosition.load(std::memory_order_relaxed);
+  while(true) {
+    Cell& cell = cells[position & mask];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+    if(difference == 0) {
+      // The cell contains the element for this position
+      if(popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        std::optional<T> element(std::move(cell.element));
+        cell.sequence.store(position + mask + 1, std::memory_order_release);
+        return element;
+      }
+    } else if(difference < 0) {
+      // The cell is still waiting for its element
+      return std::nullopt;
+    } else {
+      position = popPosition.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template<typename T>
+std::optional<T> MpmcQueue<T>::pop() {
+  while(!closed.load(std::memory_order_acquire)) {
+    uint32_t pushes = pushCount.load(std::memory_order_acquire);
+    bool finished = producers.load(std::memory_order_acquire) == 0;
+    std::optional<T> element = tryPop();
+    if(element) {
+      popCount.fetch_add(1, std::memory_order_release);
+      popCount.notify_all();
+      return element;
+    }
+    // Producers push before they are removed, so the queue stays empty, if there were no producers before it was checked
+    if(finished) {
+      return std::nullopt;
+    }
+    pushCount.wait(pushes, std::memory_order_acquire);
+  }
+  return std::nullopt;
+}
+
+template<typename T>
+void MpmcQueue<T>::addProducer() {
+  producers.fetch_add(1, std::memory_order_acq_rel);
+}
+
+template<typename T>
+void MpmcQueue<T>::removeProducer() {
+  producers.fetch_sub(1, std::memory_order_acq_rel);
+  // Wake the consumers, so they can check whether they are finished
+  notifyConsumers();
+}
+
+template<typename T>
+void MpmcQueue<T>::close() {
+  closed.store(true, std::memory_order_release);
+  notifyConsumers();
+  popCount.fetch_add(1, std::memory_order_release);
+  popCount.notify_all();
+}
+
+template<typename T>
+void MpmcQueue<T>::notifyConsumers() {
+  pushCount.fetch_add(1, std::memory_order_release);
+  pushCount.notify_all();
+}
+
+#endif
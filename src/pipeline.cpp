@@ -0,0 +1,141 @@
+#include "pipeline.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+std::string escapeJson(const std::string& value) {
+  std::stringstream escaped;
+  escaped << '"';
+  for(char character : value) {
+    switch(character) {
+      case '"':
+        escaped << "\\\"";
+        break;
+      case '\\':
+        escaped << "\\\\";
+        break;
+      case '\n':
+        escaped << "\\n";
+        break;
+      case '\r':
+        escaped << "\\r";
+        break;
+      case '\t':
+        escaped << "\\t";
+        break;
+      default:
+        if(static_cast<unsigned char>(character) < 0x20) {
+          escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(character) << std::dec;
+        } else {
+          escaped << character;
+        }
+    }
+  }
+  escaped << '"';
+  return escaped.str();
+}
+
+}  // namespace
+
+Pipeline::Pipeline(const Settings& settings, Loader& loader, Uploader& uploader)
+    : settings(settings), loader(loader), uploader(uploader), jobs(settings.getJobs() * 2), nextIndex(0) {}
+
+void Pipeline::run() {
+  std::vector<std::jthread> workers;
+  for(unsigned int i = 0; i < settings.getJobs(); i++) {
+    workers.emplace_back(&Pipeline::work, this);
+  }
+
+  size_t index = 0;
+  auto start = std::chrono::steady_clock::now();
+  // Loading includes waiting for paths from streams
+  while(std::shared_ptr<File> file = loader.getNextFile()) {
+    std::chrono::duration<double> loadDuration = std::chrono::steady_clock::now() - start;
+    jobs.push({index, std::move(file), start, loadDuration});
+    index++;
+    start = std::chrono::steady_clock::now();
+  }
+  jobs.close();
+}
+
+void Pipeline::work() {
+  while(std::optional<Job> job = jobs.pop()) {
+    Result result;
+    result.name = job->file->getName();
+    if(job->file->isSizeKnown()) {
+      result.size = job->file->getSize();
+    }
+    result.loadDuration = job->loadDuration;
+    try {
+      result.upload = uploader.uploadFile(*job->file);
+      result.size = result.upload->size;
+      result.errorMessage = result.upload->error;
+    } catch(const std::runtime_error& error) {
+      result.errorMessage = error.what();
+    }
+    result.totalDuration = std::chrono::steady_clock::now() - job->start;
+    // Release the file, before waiting for the output
+    job->file.reset();
+    finishJob(job->index, std::move(result));
+  }
+}
+
+void Pipeline::finishJob(size_t index, Result result) {
+  std::unique_lock<std::mutex> lock(outputMutex);
+  if(settings.getCompletionOrder()) {
+    printResult(result);
+    return;
+  }
+
+  pendingResults.emplace(index, std::move(result));
+  for(auto next = pendingResults.find(nextIndex); next != pendingResults.end(); next = pendingResults.find(nextIndex)) {
+    printResult(next->second);
+    pendingResults.erase(next);
+    nextIndex++;
+  }
+}
+
+void Pipeline::printResult(const Result& result) const {
+  if(settings.getJson()) {
+    printJson(result);
+  } else if(result.errorMessage.empty()) {
+    logger.log(Logger::Url) << result.upload->url << std::endl;
+  }
+  if(!result.errorMessage.empty()) {
+    logger.log(Logger::UploadFatal) << result.errorMessage << '\n';
+    // The result of the failed upload is printed, before quitting
+    if(!settings.getContinueUploading()) {
+      uploader.finish();
+      quit::failedToUpload();
+    }
+  }
+}
+
+void Pipeline::printJson(const Result& result) {
+  bool uploaded = result.errorMessage.empty();
+  std::stringstream json;
+  json << "{\"name\":" << escapeJson(result.name) << ",\"size\":";
+  if(result.size) {
+    json << *result.size;
+  } else {
+    json << "null";
+  }
+  if(uploaded) {
+    json << ",\"url\":" << escapeJson(result.upload->url) << ",\"backend\":" << escapeJson(result.upload->backend);
+  } else {
+    json << ",\"url\":null,\"backend\":null,\"error\":" << escapeJson(result.errorMessage);
+  }
+  // Failed uploads have measurements too, unless the upload could not be started
+  if(result.upload) {
+    json << ",\"bytes\":" << result.upload->bytes;
+  }
+  // Durations are in seconds. read is the time spent reading the content during the upload, which includes creating archives
+  json << ",\"durations\":{\"load\":" << result.loadDuration.count();
+  if(result.upload) {
+    json << ",\"read\":" << result.upload->readDuration.count() << ",\"upload\":" << result.upload->uploadDuration.count();
+  }
+  json << ",\"total\":" << result.totalDuration.count() << "}}";
+  logger.log(Logger::Url) << json.str() << std::endl;
+}
@@ -0,0 +1,67 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boundedqueue.hpp"
+#include "file.hpp"
+#include "loader.hpp"
+#include "settings.hpp"
+#include "uploader.hpp"
+
+// Uploads the files from a loader with multiple workers, while the loader continues loading.
+class Pipeline {
+  // A loaded file and its position in the input
+  struct Job {
+    size_t index;
+    std::shared_ptr<File> file;
+    // When loading the file started
+    std::chrono::steady_clock::time_point start;
+    std::chrono::duration<double> loadDuration;
+  };
+
+  // The outcome of a job. errorMessage is only set, if the upload failed. upload is empty, if the upload could not be started
+  struct Result {
+    std::string name;
+    // Not set, if the size of an archive is unknown, because it was not read completely
+    std::optional<size_t> size;
+    std::optional<Uploader::Upload> upload;
+    std::string errorMessage;
+    std::chrono::duration<double> loadDuration;
+    // From the start of loading until the upload finished
+    std::chrono::duration<double> totalDuration;
+  };
+
+  Settings settings;
+  Loader& loader;
+  Uploader& uploader;
+  BoundedQueue<Job> jobs;
+
+  // Lock the mutex, when printing or accessing pendingResults or nextIndex
+  std::mutex outputMutex;
+  // Finished results, that cannot be printed yet, because an earlier result is missing
+  std::map<size_t, Result> pendingResults;
+  // Index of the next result to print
+  size_t nextIndex;
+
+ public:
+  Pipeline(const Settings& settings, Loader& loader, Uploader& uploader);
+  // Load and upload all files. Returns after every file was uploaded
+  void run();
+
+ private:
+  void work();
+  void finishJob(size_t index, Result result);
+  void printResult(const Result& result) const;
+  static void printJson(const Result& result);
+};
+
+#endif
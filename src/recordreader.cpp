@@ -0,0 +1,90 @@
+#include "recordreader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+RecordReader::RecordReader(const std::filesystem::path& path, char delimiter, size_t bufferSize)
+    : delimiter(delimiter), buffer(std::max<size_t>(bufferSize, 1)), finished(false) {
+#ifdef __unix__
+  descriptor = path == "-" ? STDIN_FILENO : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(descriptor < 0) {
+    throw std::runtime_error("Failed to open " + path.string() + " . " + std::strerror(errno));
+  }
+#else
+  if(path != "-") {
+    file = std::make_unique<std::ifstream>(path, std::ios::binary);
+    if(!file->is_open()) {
+      throw std::runtime_error("Failed to open " + path.string() + " .");
+    }
+  }
+#endif
+}
+
+RecordReader::~RecordReader() {
+#ifdef __unix__
+  if(descriptor != STDIN_FILENO) {
+    close(descriptor);
+  }
+#endif
+}
+
+bool RecordReader::read(std::vector<std::string>& records) {
+  if(finished) {
+    return false;
+  }
+
+#ifdef __unix__
+  ssize_t length;
+  do {
+    // Returns as soon as some data is available, so records from slow pipes are not delayed
+    length = ::read(descriptor, buffer.data(), buffer.size());
+  } while(length < 0 && errno == EINTR);
+  if(length < 0) {
+    throw std::runtime_error(std::string("Failed to read filenames. ") + std::strerror(errno));
+  }
+#else
+  std::istream& stream = file ? *file : std::cin;
+  // Without a way to wait for some data, only one record is read at a time
+  std::string record;
+  std::getline(stream, record, delimiter);
+  if(!stream.eof()) {
+    record.push_back(delimiter);
+  }
+  buffer.assign(record.begin(), record.end());
+  size_t length = record.size();
+#endif
+
+  if(length == 0) {
+    // The last record does not need a delimiter
+    finished = true;
+    if(!partialRecord.empty()) {
+      records.push_back(std::move(partialRecord));
+    }
+    return false;
+  }
+
+  const char* position = buffer.data();
+  const char* end = buffer.data() + length;
+  while(const char* delimiterPosition = static_cast<const char*>(std::memchr(position, delimiter, end - position))) {
+    if(partialRecord.empty()) {
+      if(delimiterPosition != position) {
+        records.emplace_back(position, delimiterPosition);
+      }
+    } else {
+      partialRecord.append(position, delimiterPosition);
+      records.push_back(std::move(partialRecord));
+      partialRecord.clear();
+    }
+    position = delimiterPosition + 1;
+  }
+  partialRecord.append(position, end);
+  return true;
+}
@@ -0,0 +1,35 @@
+#ifndef RECORD_READER_HPP
+#define RECORD_READER_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reads records that are separated by a delimiter from a file or standard input. The input is read in big blocks and the
+// records can have any length.
+class RecordReader {
+  char delimiter;
+  std::vector<char> buffer;
+  // The beginning of a record, that continues in the next block
+  std::string partialRecord;
+#ifdef __unix__
+  int descriptor;
+#else
+  std::unique_ptr<std::ifstream> file;
+#endif
+  bool finished;
+
+ public:
+  // Reads standard input, if path is "-". Throws std::runtime_error, if the file cannot be opened
+  RecordReader(const std::filesystem::path& path, char delimiter, size_t bufferSize);
+  RecordReader(const RecordReader&) = delete;
+  ~RecordReader();
+  // Wait for the next block and append the records that are complete to records. Empty records are skipped.
+  // Returns false, if the end of the input was reached. Throws std::runtime_error, if reading failed
+  bool read(std::vector<std::string>& records);
+};
+
+#endif
@@ -54,6 +54,54 @@ long long Settings::getCheckTimeout() const {
   return checkTimeout;
 }
 
+size_t Settings::getBufferSize() const {
+  return bufferSize;
+}
+
+bool Settings::getMemoryMap() const {
+  return memoryMap;
+}
+
+unsigned int Settings::getJobs() const {
+  return jobs;
+}
+
+bool Settings::getCompletionOrder() const {
+  return completionOrder;
+}
+
+unsigned int Settings::getCompressionThreads() const {
+  return compressionThreads;
+}
+
+std::optional<int> Settings::getCompressionLevel() const {
+  return compressionLevel;
+}
+
+bool Settings::getNullSeparated() const {
+  return nullSeparated;
+}
+
+std::vector<std::string> Settings::getWatchDirectories() const {
+  return watchDirectories;
+}
+
+long long Settings::getWatchDelay() const {
+  return watchDelay;
+}
+
+std::optional<long long> Settings::getHedgeDelay() const {
+  return hedgeDelay;
+}
+
+long long Settings::getCacheTtl() const {
+  return cacheTtl;
+}
+
+bool Settings::getJson() const {
+  return json;
+}
+
 cxxopts::Options Settings::generateParser() {
   cxxopts::Options options("upload", "Upload files to the internet");
   // clang-format off
@@ -84,7 +132,7 @@ cxxopts::Options Settings::generateParser() {
   ("m,max-length", "Each generated url will be shorter than NUM characters.", cxxopts::value<int>(), "NUM")
   ;
   options.add_options("Mode independent")
-  ("archive-type", "Sets the archive type", cxxopts::value<std::string>()->default_value("1"), "TYPE")
+  ("archive-type", "Sets the archive type. Possible types are zip, tar, tar.gz and tar.zst", cxxopts::value<std::string>()->default_value("zip"), "TYPE")
   ("r,root-archive", "Put the contents of directories in the root of the archive.")
   ("d,directory-archive", "Put the contents of directories in a directory in the archive.")
   ("c,continue", "Do not fail if opening or uploading a file failed.")
@@ -92,8 +140,21 @@ cxxopts::Options Settings::generateParser() {
   ("continue-upload", "Do not fail if uploading a file failed.")
   ("defer-check", "Only check backends, if no other backends are available.")
   ("check-timeout", "The timeout when checking a backend.", cxxopts::value<std::string>()->default_value("500"), "TIME")
+  ("cache-ttl", "Reuse the results of backend checks from previous runs for TIME. 0 disables the cache.", cxxopts::value<std::string>()->default_value("10m"), "TIME")
+  ("race", "Upload to multiple backends at once and use the first url.")
+  ("hedge-delay", "Also upload to the next backend, if the upload did not finish after TIME. Implies --race.", cxxopts::value<std::string>(), "TIME")
+  ("buffer-size", "The size of the chunks in which files are read.", cxxopts::value<std::string>()->default_value("64K"), "BYTES")
+  ("0,null", "Filenames read from files and standard input are separated by null characters instead of newlines.")
+  ("no-mmap", "Read files into buffers instead of mapping them into memory.")
+  ("j,jobs", "Upload up to NUM files at the same time.", cxxopts::value<int>()->default_value("1"), "NUM")
+  ("completion-order", "Print the urls in the order the uploads finish, instead of the order of the files.")
+  ("json", "Print a JSON object with the url, the backend and the timings for every file, instead of the url.")
+  ("compression-level", "The compression level of the archive. 0-9 for zip and tar.gz, 1-22 for tar.zst", cxxopts::value<int>(), "LEVEL")
+  ("compression-threads", "Compress archives with NUM threads. 0 uses one thread per core.", cxxopts::value<int>()->default_value("0"), "NUM")
   ;
   options.add_options("Individual mode")
+  ("w,watch", "Upload every file that is written to or moved into DIR, until upload is stopped.", cxxopts::value<std::vector<std::string>>(), "DIR")
+  ("watch-delay", "Upload watched files after they were not written to for TIME.", cxxopts::value<std::string>()->default_value("100"), "TIME")
   ;
   options.add_options("Archive mode")
   ("n,name", "The name of the created archive in archive mode.", cxxopts::value<std::string>())
@@ -116,6 +177,10 @@ void Settings::parseOptions(int argc, char** argv) {
     }
 
     initializeLogger(result);
+    if(result.count("watch")) {
+      watchDirectories = result["watch"].template as<std::vector<std::string>>();
+    }
+    watchDelay = parseTimeString(result["watch-delay"].as<std::string>());
     mode = parseMode(result);
     files = parseFiles(result, mode);
     archiveType = parseArchiveType(result);
@@ -131,6 +196,16 @@ void Settings::parseOptions(int argc, char** argv) {
     parseContinue(result);
     deferCheck = result.count("defer-check");
     checkTimeout = parseTimeString(result["check-timeout"].as<std::string>());
+    hedgeDelay = parseHedgeDelay(result);
+    cacheTtl = parseTimeString(result["cache-ttl"].as<std::string>());
+    bufferSize = parseBufferSize(result);
+    memoryMap = !result.count("no-mmap");
+    jobs = parseJobs(result);
+    completionOrder = result.count("completion-order");
+    json = result.count("json");
+    compressionThreads = parseCompressionThreads(result);
+    compressionLevel = parseCompressionLevel(result, archiveType);
+    nullSeparated = result.count("null");
   } catch(const cxxopts::OptionException& e) {
     logger.log(Logger::Fatal) << e.what() << '\n';
     quit::invalidCliUsage();
@@ -139,6 +214,12 @@ void Settings::parseOptions(int argc, char** argv) {
 
 std::string Settings::getArchiveExtension(const Settings::ArchiveType& archiveType) {
   switch(archiveType) {
+    case ArchiveType::Tar:
+      return "tar";
+    case ArchiveType::TarGz:
+      return "tar.gz";
+    case ArchiveType::TarZst:
+      return "tar.zst";
     case ArchiveType::Zip:
     default:
       return "zip";
@@ -156,9 +237,13 @@ Settings::Mode Settings::parseMode(const auto& parseResult) {
     return Mode::List;
   }
   if(parseResult.count("archive")) {
+    if(!watchDirectories.empty()) {
+      logger.log(Logger::Fatal) << "You cannot watch directories in archive mode, because the archive would never be finished." << '\n';
+      quit::invalidCliUsage();
+    }
     return Mode::Archive;
   }
-  if(parseResult.count("individual")) {
+  if(parseResult.count("individual") || !watchDirectories.empty()) {
     return Mode::Individual;
   }
 
@@ -176,8 +261,14 @@ Settings::ArchiveType Settings::parseArchiveType(const auto& parseResult) {
 
     if(archiveTypeString == "zip") {
       return ArchiveType::Zip;
+    } else if(archiveTypeString == "tar") {
+      return ArchiveType::Tar;
+    } else if(archiveTypeString == "tar.gz" || archiveTypeString == "tgz") {
+      return ArchiveType::TarGz;
+    } else if(archiveTypeString == "tar.zst" || archiveTypeString == "tzst") {
+      return ArchiveType::TarZst;
     } else {
-      logger.log(Logger::Fatal) << "You specified an invalid archive-type. The only possible value is 'zip'" << '\n';
+      logger.log(Logger::Fatal) << "You specified an invalid archive-type. Possible values are 'zip', 'tar', 'tar.gz' and 'tar.zst'" << '\n';
       quit::invalidCliUsage();
     }
   }
@@ -185,7 +276,8 @@ Settings::ArchiveType Settings::parseArchiveType(const auto& parseResult) {
 }
 
 std::vector<std::string> Settings::parseFiles(const auto& parseResult, Settings::Mode mode) {
-  bool filesRequired = (mode == Mode::Archive || mode == Mode::Individual);
+  // Watched directories are enough to upload files
+  bool filesRequired = (mode == Mode::Archive || mode == Mode::Individual) && watchDirectories.empty();
   if(parseResult.count("file") == 0) {
     if(filesRequired) {
       if(isInteractiveSession()) {
@@ -414,6 +506,69 @@ BackendRequirements Settings::parseBackendRequirements(const auto& parseResult)
   return requirements;
 }
 
+size_t Settings::parseBufferSize(const auto& parseResult) {
+  long size = parseSizeString(parseResult["buffer-size"].template as<std::string>());
+  if(size <= 0) {
+    logger.log(Logger::Fatal) << "You specified a buffer size of " << size << " bytes. The buffer size has to be at least one byte." << '\n';
+    quit::invalidCliUsage();
+  }
+  return static_cast<size_t>(size);
+}
+
+unsigned int Settings::parseJobs(const auto& parseResult) {
+  int jobs = parseResult["jobs"].template as<int>();
+  if(jobs < 1) {
+    logger.log(Logger::Fatal) << "You specified " << jobs << " jobs, but at least one job is required to upload anything." << '\n';
+    quit::invalidCliUsage();
+  }
+  return static_cast<unsigned int>(jobs);
+}
+
+unsigned int Settings::parseCompressionThreads(const auto& parseResult) {
+  int threads = parseResult["compression-threads"].template as<int>();
+  if(threads < 0) {
+    logger.log(Logger::Fatal) << "You specified " << threads << " compression threads. Use 0 to use one thread per core." << '\n';
+    quit::invalidCliUsage();
+  }
+  return static_cast<unsigned int>(threads);
+}
+
+std::optional<long long> Settings::parseHedgeDelay(const auto& parseResult) {
+  if(parseResult.count("hedge-delay")) {
+    return parseTimeString(parseResult["hedge-delay"].template as<std::string>());
+  }
+  if(parseResult.count("race")) {
+    return 0;
+  }
+  return std::nullopt;
+}
+
+std::optional<int> Settings::parseCompressionLevel(const auto& parseResult, Settings::ArchiveType type) {
+  if(!parseResult.count("compression-level")) {
+    return std::nullopt;
+  }
+  int level = parseResult["compression-level"].template as<int>();
+  switch(type) {
+    case ArchiveType::Tar:
+      logger.log(Logger::Info) << "Tar archives are not compressed, so the compression level is ignored." << '\n';
+      return std::nullopt;
+    case ArchiveType::TarZst:
+      if(level < 1 || level > 22) {
+        logger.log(Logger::Fatal) << "You specified the compression level " << level << ", but zstd only supports levels from 1 to 22." << '\n';
+        quit::invalidCliUsage();
+      }
+      return level;
+    case ArchiveType::Zip:
+    case ArchiveType::TarGz:
+    default:
+      if(level < 0 || level > 9) {
+        logger.log(Logger::Fatal) << "You specified the compression level " << level << ", but deflate only supports levels from 0 to 9." << '\n';
+        quit::invalidCliUsage();
+      }
+      return level;
+  }
+}
+
 long long Settings::parseTimeString(const std::string& timeString) {
   size_t suffixStart = timeString.find_first_not_of("0123456789");
   if(suffixStart == std::string::npos) {
@@ -5,6 +5,7 @@
 #include <cxxopts.hpp>
 #include <filesystem>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -15,7 +16,7 @@
 class Settings {
  public:
   enum Mode { Individual, Archive, List };
-  enum ArchiveType { Zip };
+  enum ArchiveType { Zip, Tar, TarGz, TarZst };
 
  private:
   Mode mode;
@@ -30,6 +31,18 @@ class Settings {
   bool continueLoading;
   bool deferCheck;
   long long checkTimeout;
+  size_t bufferSize;
+  bool memoryMap;
+  unsigned int jobs;
+  bool completionOrder;
+  unsigned int compressionThreads;
+  std::optional<int> compressionLevel;
+  bool nullSeparated;
+  std::vector<std::string> watchDirectories;
+  long long watchDelay;
+  std::optional<long long> hedgeDelay;
+  long long cacheTtl;
+  bool json;
 
   static constexpr ArchiveType defaultArchiveType = ArchiveType::Zip;
 
@@ -47,6 +60,27 @@ class Settings {
   [[nodiscard]] bool getContinueUploading() const;
   [[nodiscard]] bool getDeferCheck() const;
   [[nodiscard]] long long getCheckTimeout() const;
+  [[nodiscard]] size_t getBufferSize() const;
+  [[nodiscard]] bool getMemoryMap() const;
+  [[nodiscard]] unsigned int getJobs() const;
+  [[nodiscard]] bool getCompletionOrder() const;
+  // 0 means one thread per core
+  [[nodiscard]] unsigned int getCompressionThreads() const;
+  // Not set, if the default level of the archive type should be used
+  [[nodiscard]] std::optional<int> getCompressionLevel() const;
+  // Filenames from streams are separated by null characters instead of newlines
+  [[nodiscard]] bool getNullSeparated() const;
+  // Directories in which new files are uploaded until upload is stopped
+  [[nodiscard]] std::vector<std::string> getWatchDirectories() const;
+  // Milliseconds a watched file has to be unchanged, before it is uploaded
+  [[nodiscard]] long long getWatchDelay() const;
+  // Milliseconds after which the next backend is started, while the upload to the previous backend continues.
+  // Not set, if backends are only tried after the previous backend failed
+  [[nodiscard]] std::optional<long long> getHedgeDelay() const;
+  // How long the results of backend checks are reused by later invocations. 0, if the cache is disabled
+  [[nodiscard]] long long getCacheTtl() const;
+  // Print a JSON object with the result and the timings for every file, instead of the url
+  [[nodiscard]] bool getJson() const;
 
  private:
   static cxxopts::Options generateParser();
@@ -60,6 +94,11 @@ class Settings {
   void initializeLogger(const auto& parseResult) const;
   void parseContinue(const auto& parseResult);
   BackendRequirements parseBackendRequirements(const auto& parseResult);
+  size_t parseBufferSize(const auto& parseResult);
+  unsigned int parseJobs(const auto& parseResult);
+  unsigned int parseCompressionThreads(const auto& parseResult);
+  std::optional<long long> parseHedgeDelay(const auto& parseResult);
+  std::optional<int> parseCompressionLevel(const auto& parseResult, Settings::ArchiveType type);
 
   [[nodiscard]] static bool isInteractiveSession();
   [[nodiscard]] static long long parseTimeString(const std::string& timeString);
@@ -1,5 +1,6 @@
 #include <fileiobackend.hpp>
 #include <ixbackend.hpp>
+#include <loopbackbackend.hpp>
 #include <nullpointerbackend.hpp>
 #include <oshibackend.hpp>
 #include <transfershbackend.hpp>
@@ -29,5 +30,9 @@ std::vector<std::shared_ptr<Backend>> loadBackends() {
     backends.push_back(std::shared_ptr<Backend>(backend));
   }
 
+  for(Backend* backend : LoopbackBackend::loadBackends()) {
+    backends.push_back(std::shared_ptr<Backend>(backend));
+  }
+
   return backends;
 }
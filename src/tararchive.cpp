@@ -0,0 +1,198 @@
+#include "tararchive.hpp"
+
+#include <algorithm>
+#include <memory>
+
+#include "compressor.hpp"
+
+namespace {
+
+constexpr size_t blockSize = 512;
+constexpr size_t maxNameLength = 100;
+// Biggest number with 11 octal digits
+constexpr uint64_t maxOctalSize = 077777777777;
+
+constexpr char typeRegular = '0';
+constexpr char typeDirectory = '5';
+constexpr char typePaxHeader = 'x';
+
+// Write value as zero padded octal number with a terminating null byte into field
+void writeOctal(char* field, size_t fieldSize, uint64_t value) {
+  for(size_t i = fieldSize - 1; i > 0; i--) {
+    field[i - 1] = static_cast<char>('0' + (value & 7));
+    value >>= 3;
+  }
+  field[fieldSize - 1] = '\0';
+}
+
+}  // namespace
+
+TarArchive::TarArchive(std::vector<ArchiveEntry> entries,
+                       size_t bufferSize,
+                       bool memoryMap,
+                       Compression compression,
+                       unsigned int compressionThreads,
+                       std::optional<int> compressionLevel)
+    : ArchiveSource(std::move(entries), bufferSize, memoryMap),
+      compression(compression),
+      compressionThreads(compressionThreads),
+      compressionLevel(compressionLevel) {}
+
+size_t TarArchive::getSize() const {
+  // Two zero blocks at the end
+  size_t size = 2 * blockSize;
+  if(compression == Compression::None) {
+    // The headers are small, so creating them is cheaper than generating the archive
+    for(const ArchiveEntry& entry : entries) {
+      std::string name = entry.directory ? entry.name + "/" : entry.name;
+      if(name.size() > maxNameLength || entry.size > maxOctalSize) {
+        size += createPaxHeader(name, entry).size();
+      }
+      size += blockSize;
+      if(!entry.directory) {
+        size += entry.size + getPadding(entry.size);
+      }
+    }
+    return size;
+  }
+
+  for(const ArchiveEntry& entry : entries) {
+    // Header, pax header with long name and padded content
+    size += 3 * blockSize + entry.name.size() + entry.size + getPadding(entry.name.size()) + getPadding(entry.size);
+  }
+  // The padding of the last compressed block
+  switch(compression) {
+    case Compression::Gzip:
+      // Data that does not compress, stored block headers and the gzip header and trailer
+      return size + size / 16000 * 5 + size / BlockDeflater::blockSize * 6 + 32;
+    case Compression::Zstd:
+      // Data that does not compress is stored with a small overhead per block
+      return size + size / 128 + 1024;
+    case Compression::None:
+    default:
+      return size;
+  }
+}
+
+bool TarArchive::isSizeKnown() const {
+  return compression == Compression::None;
+}
+
+bool TarArchive::write(const File::ChunkCallback& callback) {
+  std::unique_ptr<StreamCompressor> compressor;
+  switch(compression) {
+    case Compression::Gzip:
+      compressor = std::make_unique<GzipCompressor>(callback, compressionThreads, compressionLevel.value_or(GzipCompressor::defaultLevel));
+      break;
+    case Compression::Zstd:
+      compressor = std::make_unique<ZstdCompressor>(callback, compressionThreads, compressionLevel.value_or(ZstdCompressor::defaultLevel));
+      break;
+    case Compression::None:
+    default:
+      return writeEntries(callback);
+  }
+  bool finished = writeEntries([&compressor](const char* data, size_t length) {
+    return compressor->write(data, length);
+  });
+  return finished && compressor->finish();
+}
+
+bool TarArchive::writeEntries(const File::ChunkCallback& output) {
+  for(const ArchiveEntry& entry : entries) {
+    if(!writeEntry(entry, output)) {
+      return false;
+    }
+  }
+  std::string end(2 * blockSize, '\0');
+  return output(end.data(), end.size());
+}
+
+bool TarArchive::writeEntry(const ArchiveEntry& entry, const File::ChunkCallback& output) {
+  std::string name = entry.directory ? entry.name + "/" : entry.name;
+  uint32_t mode = static_cast<uint32_t>(entry.permissions & std::filesystem::perms::mask);
+  std::string header;
+  if(name.size() > maxNameLength || entry.size > maxOctalSize) {
+    header = createPaxHeader(name, entry);
+  }
+  header.append(createHeader(name, entry.size, mode, entry.modificationTime, entry.directory ? typeDirectory : typeRegular));
+  if(!output(header.data(), header.size())) {
+    return false;
+  }
+  if(entry.directory) {
+    return true;
+  }
+
+  // The size in the header is binding, so a file that changed since the entry was created is cut off or padded with zeros
+  uint64_t remaining = entry.size;
+  bool stopped = false;
+  File file = openEntry(entry);
+  file.readChunks([&](const char* data, size_t length) {
+    size_t written = static_cast<size_t>(std::min<uint64_t>(length, remaining));
+    if(written > 0 && !output(data, written)) {
+      stopped = true;
+      return false;
+    }
+    remaining -= written;
+    return remaining > 0;
+  });
+  if(stopped) {
+    return false;
+  }
+  remaining += getPadding(entry.size);
+  std::string zeros(blockSize, '\0');
+  while(remaining > 0) {
+    size_t written = static_cast<size_t>(std::min<uint64_t>(remaining, blockSize));
+    if(!output(zeros.data(), written)) {
+      return false;
+    }
+    remaining -= written;
+  }
+  return true;
+}
+
+std::string TarArchive::createHeader(const std::string& name, uint64_t size, uint32_t mode, std::time_t modificationTime, char type) {
+  std::string header(blockSize, '\0');
+  // Names and sizes that do not fit are in the pax header, so these fields are only a fallback for old readers
+  std::copy_n(name.begin(), std::min(name.size(), maxNameLength), header.begin());
+  writeOctal(&header[100], 8, mode);
+  writeOctal(&header[108], 8, 0);
+  writeOctal(&header[116], 8, 0);
+  writeOctal(&header[124], 12, std::min(size, maxOctalSize));
+  writeOctal(&header[136], 12, static_cast<uint64_t>(std::max<std::time_t>(modificationTime, 0)));
+  header[156] = type;
+  std::copy_n("ustar\0" "00", 8, &header[257]);
+
+  // The checksum is calculated with spaces in the checksum field
+  std::fill_n(&header[148], 8, ' ');
+  unsigned int checksum = 0;
+  for(char byte : header) {
+    checksum += static_cast<unsigned char>(byte);
+  }
+  writeOctal(&header[148], 7, checksum);
+  return header;
+}
+
+std::string TarArchive::createPaxHeader(const std::string& name, const ArchiveEntry& entry) {
+  std::string records = createPaxRecord("path", name);
+  if(entry.size > maxOctalSize) {
+    records.append(createPaxRecord("size", std::to_string(entry.size)));
+  }
+  std::string header = createHeader("././@PaxHeader", records.size(), 0644, entry.modificationTime, typePaxHeader);
+  header.append(records);
+  header.append(getPadding(records.size()), '\0');
+  return header;
+}
+
+std::string TarArchive::createPaxRecord(const std::string& key, const std::string& value) {
+  // A record is "<length> <key>=<value>\n", where the length includes its own digits
+  std::string record = " " + key + "=" + value + "\n";
+  size_t length = record.size() + 1;
+  while(std::to_string(length).size() + record.size() != length) {
+    length++;
+  }
+  return std::to_string(length) + record;
+}
+
+size_t TarArchive::getPadding(uint64_t size) {
+  return static_cast<size_t>((blockSize - size % blockSize) % blockSize);
+}
@@ -0,0 +1,48 @@
+#ifndef TAR_ARCHIVE_HPP
+#define TAR_ARCHIVE_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "archive.hpp"
+
+// Generates a tar archive in the pax format, that can be compressed with gzip or zstd while it is written.
+// Long names and sizes that do not fit into the ustar header are stored in pax extended headers.
+class TarArchive: public ArchiveSource {
+ public:
+  enum class Compression { None, Gzip, Zstd };
+
+ private:
+  Compression compression;
+  // Uses one thread per core, if this is 0
+  unsigned int compressionThreads;
+  // Uses the default level of the compression, if not set
+  std::optional<int> compressionLevel;
+
+ public:
+  TarArchive(std::vector<ArchiveEntry> entries,
+             size_t bufferSize,
+             bool memoryMap,
+             Compression compression = Compression::None,
+             unsigned int compressionThreads = 0,
+             std::optional<int> compressionLevel = std::nullopt);
+  // The size of uncompressed archives is exact
+  [[nodiscard]] size_t getSize() const override;
+  [[nodiscard]] bool isSizeKnown() const override;
+
+ protected:
+  bool write(const File::ChunkCallback& callback) override;
+
+ private:
+  bool writeEntries(const File::ChunkCallback& output);
+  bool writeEntry(const ArchiveEntry& entry, const File::ChunkCallback& output);
+  static std::string createHeader(const std::string& name, uint64_t size, uint32_t mode, std::time_t modificationTime, char type);
+  static std::string createPaxHeader(const std::string& name, const ArchiveEntry& entry);
+  static std::string createPaxRecord(const std::string& key, const std::string& value);
+  // The number of zero bytes, that pad size to a multiple of the block size
+  static size_t getPadding(uint64_t size);
+};
+
+#endif
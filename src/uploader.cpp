@@ -1,63 +1,383 @@
 #include "uploader.hpp"
 
-Uploader::Uploader(const Settings& settings): settings(settings) {
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+Uploader::Uploader(const Settings& settings): lastSave(std::chrono::steady_clock::now()), settings(settings) {
+  if(settings.getCacheTtl() > 0) {
+    cachePath = BackendStatistics::getDefaultCachePath();
+  }
+  if(cachePath && !statistics.load(*cachePath)) {
+    UPLOAD_LOG(Logger::Debug) << "There are no cached backend statistics in " << *cachePath << "." << '\n';
+  }
   initializeBackends();
   if(settings.getMode() == Settings::Mode::List) {
     printAvailableBackends();
+    saveStatistics(true);
     quit::success();
   }
 }
 
-std::string Uploader::uploadFile(const File& file) {
-  // This loop does not need to lock the mutex
-  while(checkedBackends.empty() && !backends.empty()) {
-    backends.front().get();
-    backends.pop();
+Uploader::~Uploader() {
+  finish();
+}
+
+void Uploader::finish() {
+  std::vector<Racer> runningRacers;
+  {
+    std::unique_lock<std::mutex> lock(racersMutex);
+    for(Racer& racer : racers) {
+      racer.race->cancelled = true;
+    }
+    runningRacers = std::move(racers);
+    racers.clear();
   }
+  // Destroying the threads joins them
+  runningRacers.clear();
+  saveStatistics(true);
+}
 
-  size_t pos;
-  // This loop does not need to lock the mutex here
-  for(pos = 0; pos < checkedBackends.size(); pos++) {
-    std::shared_ptr<Backend> backend;
-    {
-      std::unique_lock<std::mutex> lock(checkedBackendsMutex);
-      backend = checkedBackends[pos];
+namespace {
+
+// Passes the content of a file through, until the upload is cancelled. Cancelling stops reading, so the backend aborts its request.
+class CancellableSource: public File::Source {
+  File file;
+  const std::atomic<bool>& cancelled;
+
+ public:
+  CancellableSource(File file, const std::atomic<bool>& cancelled): file(std::move(file)), cancelled(cancelled) {}
+
+  [[nodiscard]] size_t getSize() const override {
+    return file.getSize();
+  }
+
+  [[nodiscard]] bool isSizeKnown() const override {
+    return file.isSizeKnown();
+  }
+
+  size_t getExactSize() override {
+    checkCancelled();
+    return file.getExactSize();
+  }
+
+  size_t read(size_t offset, char* buffer, size_t length) override {
+    checkCancelled();
+    return file.read(offset, buffer, length);
+  }
+
+  std::string_view getContent() override {
+    checkCancelled();
+    return file.getContent();
+  }
+
+  bool readChunks(const File::ChunkCallback& callback, size_t offset, size_t) override {
+    return file.readChunks(
+        [this, &callback](const char* data, size_t length) {
+          return !cancelled && callback(data, length);
+        },
+        offset);
+  }
+
+ private:
+  void checkCancelled() const {
+    if(cancelled) {
+      throw std::runtime_error("The upload was cancelled.");
+    }
+  }
+};
+
+// Passes the content of a file through and measures how much content was read and how long it took to read it. The time the reader
+// spends with a chunk is not counted.
+class MeasuredSource: public File::Source {
+  File file;
+  std::atomic<size_t> bytes = 0;
+  std::atomic<std::chrono::steady_clock::duration::rep> readTime = 0;
+  static constexpr size_t unknownSize = SIZE_MAX;
+  // The number of bytes of the first complete read
+  std::atomic<size_t> contentSize = unknownSize;
+
+ public:
+  explicit MeasuredSource(File file): file(std::move(file)) {}
+
+  [[nodiscard]] size_t getSize() const override {
+    return file.getSize();
+  }
+
+  [[nodiscard]] bool isSizeKnown() const override {
+    return file.isSizeKnown();
+  }
+
+  // Generating the content counts as reading time. Its bytes are counted, when they are read
+  size_t getExactSize() override {
+    auto start = std::chrono::steady_clock::now();
+    size_t size = file.getExactSize();
+    measure(start, 0);
+    return size;
+  }
+
+  size_t read(size_t offset, char* buffer, size_t length) override {
+    auto start = std::chrono::steady_clock::now();
+    size_t readBytes = file.read(offset, buffer, length);
+    measure(start, readBytes);
+    return readBytes;
+  }
+
+  std::string_view getContent() override {
+    auto start = std::chrono::steady_clock::now();
+    std::string_view content = file.getContent();
+    measure(start, content.size());
+    return content;
+  }
+
+  bool readChunks(const File::ChunkCallback& callback, size_t offset, size_t) override {
+    auto start = std::chrono::steady_clock::now();
+    size_t readBytes = 0;
+    bool finished = file.readChunks(
+        [this, &callback, &start, &readBytes](const char* data, size_t length) {
+          measure(start, length);
+          readBytes += length;
+          bool continueReading = callback(data, length);
+          start = std::chrono::steady_clock::now();
+          return continueReading;
+        },
+        offset);
+    measure(start, 0);
+    if(finished && offset == 0) {
+      size_t expected = unknownSize;
+      contentSize.compare_exchange_strong(expected, readBytes);
+    }
+    return finished;
+  }
+
+  [[nodiscard]] size_t getBytes() const {
+    return bytes;
+  }
+
+  // Get the exact size, if it is known or the content was read completely
+  [[nodiscard]] std::optional<size_t> getContentSize() const {
+    if(file.isSizeKnown()) {
+      return file.getSize();
+    }
+    size_t size = contentSize;
+    return size == unknownSize ? std::nullopt : std::optional<size_t>(size);
+  }
+
+  [[nodiscard]] std::chrono::duration<double> getReadDuration() const {
+    return std::chrono::steady_clock::duration(readTime);
+  }
+
+ private:
+  void measure(std::chrono::steady_clock::time_point start, size_t readBytes) {
+    readTime += (std::chrono::steady_clock::now() - start).count();
+    bytes += readBytes;
+  }
+};
+
+}  // namespace
+
+Uploader::Upload Uploader::uploadFile(const File& file) {
+  // Detect the mimetype before the content is measured, so sniffing the first bytes is not counted as uploaded content
+  const std::string& mimetype = file.getMimetype();
+  UPLOAD_LOG(Logger::Debug) << "Uploading " << file.getName() << " as " << mimetype << '\n';
+  auto source = std::make_shared<MeasuredSource>(file);
+  File measuredFile(file, source);
+  auto start = std::chrono::steady_clock::now();
+  Upload upload;
+  try {
+    upload = settings.getHedgeDelay() ? raceFile(measuredFile) : uploadFileSequentially(measuredFile);
+  } catch(const std::runtime_error& error) {
+    upload.error = error.what();
+  }
+  upload.uploadDuration = std::chrono::steady_clock::now() - start;
+  upload.size = source->getContentSize();
+  upload.bytes = source->getBytes();
+  upload.readDuration = source->getReadDuration();
+  return upload;
+}
+
+Uploader::Upload Uploader::uploadFileSequentially(const File& file) {
+  Ranking ranking;
+  for(size_t pos = 0;; pos++) {
+    std::shared_ptr<Backend> backend = getRankedBackend(file, ranking, pos);
+    if(backend == nullptr) {
+      break;
     }
     try {
-      return uploadFile(file, backend);
+      Upload upload;
+      upload.url = uploadFile(file, backend);
+      upload.backend = backend->getName();
+      return upload;
     } catch(const std::runtime_error& e) {
       logger.log(Logger::Info) << "Failed to upload " << file.getName() << " to " << backend->getName() << ". " << e.what() << '\n';
+      statistics.recordFailure(backend->getName());
+      saveStatistics();
     } catch(...) {
       logger.log(Logger::Info) << "Unexpected error while uploading " << file.getName() << " to " << backend->getName() << "." << '\n';
     }
+  }
+  failedToUpload(file);
+}
+
+Uploader::Upload Uploader::raceFile(const File& file) {
+  auto race = std::make_shared<Race>();
+  File racedFile(file, std::make_shared<CancellableSource>(file, race->cancelled));
+  std::chrono::milliseconds hedgeDelay(*settings.getHedgeDelay());
+
+  Ranking ranking;
+  size_t started = 0;
+  size_t handledFailures = 0;
+  bool backendsLeft = true;
+  auto nextStart = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(race->mutex);
+  while(true) {
+    if(race->url) {
+      // The losers stop at their next chunk
+      race->cancelled = true;
+      Upload upload;
+      upload.url = *race->url;
+      upload.backend = race->backend;
+      return upload;
+    }
 
-    // This loop does not need to lock the mutex
-    while(pos == checkedBackends.size() - 1 && !backends.empty()) {
-      backends.front().get();
-      backends.pop();
+    size_t running = started - race->failures;
+    bool failed = race->failures > handledFailures;
+    handledFailures = race->failures;
+    bool hedge = std::chrono::steady_clock::now() >= nextStart && running < maxRacingBackends;
+    if(backendsLeft && (failed || hedge || running == 0)) {
+      // Checking a backend can take a while, so the racers are not blocked meanwhile
+      lock.unlock();
+      std::shared_ptr<Backend> backend = getRankedBackend(file, ranking, started);
+      if(backend != nullptr) {
+        if(started > 0) {
+          UPLOAD_LOG(Logger::Debug) << "Also uploading " << file.getName() << " to " << backend->getName() << "." << '\n';
+        }
+        startRacer(racedFile, backend, race);
+        started++;
+        nextStart = std::chrono::steady_clock::now() + hedgeDelay;
+      } else {
+        backendsLeft = false;
+      }
+      lock.lock();
+      continue;
+    }
+    if(running == 0) {
+      break;
+    }
+
+    auto stateChanged = [&race, handledFailures]() {
+      return race->url || race->failures > handledFailures;
+    };
+    if(backendsLeft && running < maxRacingBackends) {
+      race->changed.wait_until(lock, nextStart, stateChanged);
+    } else {
+      race->changed.wait(lock, stateChanged);
     }
   }
+  lock.unlock();
+  failedToUpload(file);
+}
 
+void Uploader::startRacer(const File& file, const std::shared_ptr<Backend>& backend, const std::shared_ptr<Race>& race) {
+  auto finished = std::make_shared<std::atomic<bool>>(false);
+  // The race is over, before the losers noticed that they were cancelled, so the thread owns everything it needs except the uploader
+  std::jthread thread([this, file, backend, race, finished]() {
+    std::optional<std::string> url;
+    try {
+      url = uploadFile(file, backend);
+    } catch(const std::runtime_error& e) {
+      // Cancelled uploads are not the fault of the backend
+      if(!race->cancelled) {
+        logger.log(Logger::Info) << "Failed to upload " << file.getName() << " to " << backend->getName() << ". " << e.what() << '\n';
+        statistics.recordFailure(backend->getName());
+        saveStatistics();
+      }
+    } catch(...) {
+      logger.log(Logger::Info) << "Unexpected error while uploading " << file.getName() << " to " << backend->getName() << "." << '\n';
+    }
+    {
+      std::unique_lock<std::mutex> lock(race->mutex);
+      if(url && !race->url) {
+        race->url = std::move(url);
+        race->backend = backend->getName();
+      } else if(!url) {
+        race->failures++;
+      }
+    }
+    race->changed.notify_all();
+    *finished = true;
+  });
+
+  std::unique_lock<std::mutex> lock(racersMutex);
+  // Erasing the racers of previous races, that returned already, joins them
+  std::erase_if(racers, [](const Racer& racer) {
+    return racer.finished->load();
+  });
+  racers.push_back({race, finished, std::move(thread)});
+}
+
+void Uploader::failedToUpload(const File& file) {
   std::stringstream message;
   message << "Failed to upload " << file.getName() << " to any backend.";
-  if(settings.getContinueUploading()) {
-    throw std::runtime_error(message.str());
-  } else {
-    logger.log(Logger::Fatal) << message.str() << '\n';
-    quit::failedToUpload();
+  throw std::runtime_error(message.str());
+}
+
+std::shared_ptr<Backend> Uploader::getCheckedBackend(size_t position) {
+  while(getCheckedBackendCount() <= position && checkNextBackend()) {
   }
+  std::unique_lock<std::mutex> lock(checkedBackendsMutex);
+  if(position >= checkedBackends.size()) {
+    return nullptr;
+  }
+  return checkedBackends[position];
 }
 
-std::string Uploader::uploadFile(const File& file, const std::shared_ptr<Backend>& backend) {
-  if(!backend->staticFileCheck(settings.getBackendRequirements(), file)) {
-    std::stringstream message;
-    message << backend->getName() << " does not accept files like " << file.getName() << ".";
-    throw std::runtime_error(message.str());
+std::shared_ptr<Backend> Uploader::getRankedBackend(const File& file, Ranking& ranking, size_t position) {
+  while(position >= ranking.backends.size()) {
+    if(getCheckedBackend(ranking.checkedBackends) == nullptr) {
+      return nullptr;
+    }
+
+    std::vector<std::pair<double, std::shared_ptr<Backend>>> rankedBackends;
+    {
+      std::unique_lock<std::mutex> lock(checkedBackendsMutex);
+      for(; ranking.checkedBackends < checkedBackends.size(); ranking.checkedBackends++) {
+        const std::shared_ptr<Backend>& backend = checkedBackends[ranking.checkedBackends];
+        rankedBackends.emplace_back(statistics.getExpectedTime(backend->getName(), file.getSize()), backend);
+      }
+    }
+    // A backend that refuses the file did not fail, so it is not tried and its statistics are not changed
+    std::erase_if(rankedBackends, [this, &file](const auto& rankedBackend) {
+      if(rankedBackend.second->staticFileCheck(settings.getBackendRequirements(), file)) {
+        return false;
+      }
+      UPLOAD_LOG(Logger::Debug) << rankedBackend.second->getName() << " does not accept files like " << file.getName() << "." << '\n';
+      return true;
+    });
+    // Explicitly requested backends are used in the requested order
+    if(settings.getRequestedBackends().empty()) {
+      std::stable_sort(rankedBackends.begin(), rankedBackends.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      });
+    }
+    for(auto& [expectedTime, backend] : rankedBackends) {
+      UPLOAD_LOG(Logger::Debug) << "Expecting " << backend->getName() << " to upload " << file.getName() << " in " << expectedTime << "s."
+                                << '\n';
+      ranking.backends.push_back(std::move(backend));
+    }
   }
+  return ranking.backends[position];
+}
+
+std::string Uploader::uploadFile(const File& file, const std::shared_ptr<Backend>& backend) {
+  // The size of archives is only an upper bound, so the throughput is measured with the bytes this backend actually read
+  auto source = std::make_shared<MeasuredSource>(file);
+  File measuredFile(file, source);
   std::promise<std::string> urlPromise;
+  auto start = std::chrono::steady_clock::now();
   backend->uploadFile(
       settings.getBackendRequirements(),
-      file,
+      measuredFile,
       [this, &urlPromise](const std::string& url) {
         try {
           urlPromise.set_value(url);
@@ -72,13 +392,15 @@ std::string Uploader::uploadFile(const File& file, const std::shared_ptr<Backend
         urlPromise.set_exception(std::make_exception_ptr(std::runtime_error(message)));
       });
 
-  return urlPromise.get_future().get();
+  std::string url = urlPromise.get_future().get();
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  statistics.recordUpload(backend->getName(), source->getBytes(), duration.count());
+  saveStatistics();
+  return url;
 }
 
 void Uploader::printAvailableBackends() {
-  while(!backends.empty()) {
-    backends.front().get();
-    backends.pop();
+  while(checkNextBackend()) {
   }
   std::unique_lock<std::mutex> lock(checkedBackendsMutex);
   for(const std::shared_ptr<Backend>& backend : checkedBackends) {
@@ -129,25 +451,77 @@ void Uploader::initializeBackends() {
     launchPolicy = std::launch::async;
   }
 
+  std::chrono::milliseconds cacheTtl(settings.getCacheTtl());
+  std::vector<std::shared_ptr<Backend>> failingBackends;
   for(const std::shared_ptr<Backend>& backend : loadedBackends) {
-    if(backend->staticSettingsCheck(settings.getBackendRequirements())) {
-      logger.log(Logger::Debug) << backend->getName() << " has all required features." << '\n';
-      backends.emplace(std::async(launchPolicy, &Uploader::checkBackend, this, backend));
+    if(!backend->staticSettingsCheck(settings.getBackendRequirements())) {
+      UPLOAD_LOG(Logger::Debug) << backend->getName() << " does not have all required features." << '\n';
+      continue;
+    }
+    UPLOAD_LOG(Logger::Debug) << backend->getName() << " has all required features." << '\n';
+    BackendStatistics::Health health = cachePath ? statistics.getHealth(backend->getName(), cacheTtl) : BackendStatistics::Health::Unknown;
+    if(health == BackendStatistics::Health::Reachable) {
+      UPLOAD_LOG(Logger::Debug) << backend->getName() << " was reachable recently, so it is not checked again." << '\n';
+      std::unique_lock<std::mutex> lock(checkedBackendsMutex);
+      checkedBackends.push_back(backend);
+    } else if(health == BackendStatistics::Health::Unreachable) {
+      failingBackends.push_back(backend);
     } else {
-      logger.log(Logger::Debug) << backend->getName() << " does not have all required features." << '\n';
+      backends.emplace(std::async(launchPolicy, &Uploader::checkBackend, this, backend));
     }
   }
+  // Backends that were unreachable recently are only checked, if all other backends failed
+  for(const std::shared_ptr<Backend>& backend : failingBackends) {
+    UPLOAD_LOG(Logger::Debug) << backend->getName() << " was unreachable recently, so it is checked last." << '\n';
+    backends.emplace(std::async(std::launch::deferred, &Uploader::checkBackend, this, backend));
+  }
+}
+
+bool Uploader::checkNextBackend() {
+  std::unique_lock<std::mutex> lock(backendsMutex);
+  if(backends.empty()) {
+    return false;
+  }
+  backends.front().get();
+  backends.pop();
+  return true;
+}
+
+size_t Uploader::getCheckedBackendCount() {
+  std::unique_lock<std::mutex> lock(checkedBackendsMutex);
+  return checkedBackends.size();
 }
 
 void Uploader::checkBackend(const std::shared_ptr<Backend>& backend) {
+  auto start = std::chrono::steady_clock::now();
   backend->dynamicSettingsCheck(
       settings.getBackendRequirements(),
-      [this, &backend]() {
-        std::unique_lock<std::mutex> lock(checkedBackendsMutex);
-        checkedBackends.push_back(backend);
+      [this, &backend, start]() {
+        // The check is a request without content, so it measures the latency
+        std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+        statistics.recordLatency(backend->getName(), latency.count());
+        {
+          std::unique_lock<std::mutex> lock(checkedBackendsMutex);
+          checkedBackends.push_back(backend);
+        }
+        saveStatistics();
       },
-      [this](const std::string& message) {
+      [this, &backend](const std::string& message) {
         logger.log(Logger::Info) << "Failed to check backend: " << message << "." << '\n';
+        statistics.recordUnreachable(backend->getName());
+        saveStatistics();
       },
       (int)settings.getCheckTimeout());
 }
+
+void Uploader::saveStatistics(bool force) {
+  std::unique_lock<std::mutex> lock(saveMutex);
+  auto now = std::chrono::steady_clock::now();
+  if(!cachePath || !statistics.isChanged() || (!force && now - lastSave < saveInterval)) {
+    return;
+  }
+  lastSave = now;
+  if(!statistics.save(*cachePath)) {
+    UPLOAD_LOG(Logger::Debug) << "Failed to write the backend statistics to " << *cachePath << "." << '\n';
+  }
+}
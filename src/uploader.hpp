@@ -1,37 +1,139 @@
 #ifndef UPLOADER_HPP
 #define UPLOADER_HPP
 
+#include <atomic>
+#include <chrono>
 #include <backend.hpp>
+#include <condition_variable>
+#include <filesystem>
 #include <future>
 #include <list>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "backendloader.hpp"
+#include "backendstatistics.hpp"
 #include "logger.hpp"
 #include "quit.hpp"
 #include "settings.hpp"
 
+// Uploads files to the first backend that accepts them. Files can be uploaded from multiple threads at the same time.
+// The checked backends are tried in the order of their expected upload time for the file, based on the previous checks and uploads.
+// The measurements are cached, so later invocations can skip checking backends that were reachable recently.
+// In race mode, the next backend is started after a delay or a failure, while the previous uploads continue. The first url wins and
+// the other uploads are cancelled.
 class Uploader {
+ public:
+  // The result of an upload. The measurements are also set for failed uploads
+  struct Upload {
+    // Empty, if the upload to every backend failed
+    std::string url;
+    // Why the upload failed. Empty, if it succeeded
+    std::string error;
+    // The name of the backend that returned url
+    std::string backend;
+    // The size of the content. The size of archives is only known, after a backend read them completely
+    std::optional<size_t> size;
+    // Bytes of content read by all tried backends, including failed and cancelled uploads
+    size_t bytes = 0;
+    // Time spent reading the content, including creating archives, while it was uploaded
+    std::chrono::duration<double> readDuration{};
+    // Time from the first upload attempt until url was returned
+    std::chrono::duration<double> uploadDuration{};
+  };
+
+ private:
+  // The state of the uploads of one file to multiple backends
+  struct Race {
+    // Lock the mutex, when accessing url, backend or failures
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::optional<std::string> url;
+    std::string backend;
+    size_t failures = 0;
+    // Stops the uploads that are still running
+    std::atomic<bool> cancelled = false;
+  };
+
+  // The backends in the order in which they are tried for one file
+  struct Ranking {
+    std::vector<std::shared_ptr<Backend>> backends;
+    // The number of checked backends, that were ranked or rejected the file
+    size_t checkedBackends = 0;
+  };
+
+  // An upload of a race in its own thread
+  struct Racer {
+    std::shared_ptr<Race> race;
+    // Set by the thread, before it returns
+    std::shared_ptr<std::atomic<bool>> finished;
+    std::jthread thread;
+  };
+
+  // The statistics are written to the cache at most this often while uploading, and when the uploader finishes
+  static constexpr std::chrono::seconds saveInterval{30};
+  // Uploads to more backends at once would only share the bandwidth
+  static constexpr size_t maxRacingBackends = 3;
+
   // Lock the mutex, when accessing checkedBackends;
   std::mutex checkedBackendsMutex;
+  // Lock the mutex, when accessing backends;
+  std::mutex backendsMutex;
   std::queue<std::future<void>> backends;
   std::vector<std::shared_ptr<Backend>> checkedBackends;
+  BackendStatistics statistics;
+  // Lock the mutex, when accessing racers
+  std::mutex racersMutex;
+  // The losers of a race keep running, until they notice that they were cancelled. They use the uploader, so they are joined before it
+  // is destroyed
+  std::vector<Racer> racers;
+  // Not set, if the cache is disabled
+  std::optional<std::filesystem::path> cachePath;
+  // Lock the mutex, when accessing lastSave
+  std::mutex saveMutex;
+  std::chrono::steady_clock::time_point lastSave;
 
   Settings settings;
 
  public:
   explicit Uploader(const Settings& settings);
-  std::string uploadFile(const File& file);
+  Uploader(const Uploader&) = delete;
+  ~Uploader();
+  // Returns an upload with an error, if the upload to every backend failed
+  Upload uploadFile(const File& file);
+  // Cancel the uploads that are still running, wait for them and save the statistics. Call this before quitting
+  void finish();
 
  private:
+  // The backend has to accept file. Backends in the ranking of file do
   std::string uploadFile(const File& file, const std::shared_ptr<Backend>& backend);
+  // Returns an upload with the url and the backend
+  Upload uploadFileSequentially(const File& file);
+  Upload raceFile(const File& file);
+  // Upload file to backend in a new thread and report the result to race
+  void startRacer(const File& file, const std::shared_ptr<Backend>& backend, const std::shared_ptr<Race>& race);
+  // Throws std::runtime_error
+  [[noreturn]] static void failedToUpload(const File& file);
+  // Get the backend at position, after checking more backends if necessary. Returns nullptr, if there are not enough backends
+  std::shared_ptr<Backend> getCheckedBackend(size_t position);
+  // Get the backend at position in the ranking for file. When the ranking runs out of backends, the newly checked backends are ranked and
+  // appended, so the order of the backends that were already tried does not change. Backends that do not accept file are left out.
+  // Returns nullptr, if there are not enough backends
+  std::shared_ptr<Backend> getRankedBackend(const File& file, Ranking& ranking, size_t position);
   void printAvailableBackends();
   void initializeBackends();
   void checkBackend(const std::shared_ptr<Backend>& backend);
+  // Write the statistics to the cache, if they changed. Unless force is set, they are written at most once per saveInterval.
+  // Failures are only logged, because the cache is optional
+  void saveStatistics(bool force = false);
+  // Wait for the next pending backend check. Returns false, if there are no pending checks
+  bool checkNextBackend();
+  size_t getCheckedBackendCount();
 };
 
 #endif
@@ -0,0 +1,411 @@
+#include "ziparchive.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <set>
+#include <stdexcept>
+
+#include "compressor.hpp"
+
+namespace {
+
+constexpr uint32_t localHeaderSignature = 0x04034b50;
+constexpr uint32_t dataDescriptorSignature = 0x08074b50;
+constexpr uint32_t centralHeaderSignature = 0x02014b50;
+constexpr uint32_t zip64EndSignature = 0x06064b50;
+constexpr uint32_t zip64LocatorSignature = 0x07064b50;
+constexpr uint32_t endSignature = 0x06054b50;
+
+constexpr uint16_t versionDefault = 20;
+constexpr uint16_t versionZip64 = 45;
+// Upper byte 3 = unix, lower byte = zip specification 6.3
+constexpr uint16_t versionMadeBy = (3 << 8) | 63;
+
+// Bit 3: sizes and crc are in the data descriptor, bit 11: names are utf-8
+constexpr uint16_t flagDataDescriptor = 1 << 3;
+constexpr uint16_t flagUtf8 = 1 << 11;
+
+constexpr uint16_t methodStore = 0;
+constexpr uint16_t methodDeflate = 8;
+
+constexpr uint16_t zip64ExtraId = 0x0001;
+constexpr uint32_t max32 = 0xffffffff;
+constexpr uint16_t max16 = 0xffff;
+// Members bigger than this could exceed 4 GiB after compression
+constexpr uint64_t zip64Threshold = 0xf0000000;
+
+// Members of unknown type are only deflated, if deflating a sample of this size saves at least 1/minimumSavings of it.
+// Smaller members are always deflated. A fast level is good enough to tell whether the data compresses
+constexpr size_t sampleSize = 64 * 1024;
+constexpr size_t minimumSavings = 16;
+constexpr int sampleLevel = 1;
+
+constexpr uint32_t unixDirectoryMode = 0040000;
+constexpr uint32_t unixRegularMode = 0100000;
+constexpr uint32_t dosDirectoryAttribute = 0x10;
+
+template<typename T>
+void append(std::string& buffer, T value) {
+  for(size_t i = 0; i < sizeof(T); i++) {
+    buffer.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xff));
+  }
+}
+
+void toDosTime(std::time_t time, uint16_t& dosTime, uint16_t& dosDate) {
+  std::tm local{};
+  localtime_r(&time, &local);
+  if(local.tm_year < 80) {
+    // Dos time starts in 1980
+    dosTime = 0;
+    dosDate = (1 << 5) | 1;
+    return;
+  }
+  dosTime = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+  dosDate = static_cast<uint16_t>(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+}
+
+}  // namespace
+
+ZipArchive::ZipArchive(std::vector<ArchiveEntry> entries,
+                       size_t bufferSize,
+                       bool memoryMap,
+                       unsigned int compressionThreads,
+                       std::optional<int> compressionLevel)
+    : ArchiveSource(std::move(entries), bufferSize, memoryMap), compressionThreads(compressionThreads), compressionLevel(compressionLevel) {}
+
+size_t ZipArchive::getSize() const {
+  // Headers with zip64 fields, data that does not compress and a few bytes of deflate overhead per block
+  size_t size = 22 + 56 + 20;
+  for(const ArchiveEntry& entry : entries) {
+    size += 2 * entry.name.size() + 30 + 20 + 24 + 46 + 28;
+    size += entry.size + entry.size / 16000 * 5 + entry.size / BlockDeflater::blockSize * 6 + 8;
+  }
+  return size;
+}
+
+bool ZipArchive::write(const File::ChunkCallback& callback) {
+  uint64_t offset = 0;
+  File::ChunkCallback output = [&offset, &callback](const char* data, size_t length) {
+    offset += length;
+    return callback(data, length);
+  };
+
+  std::vector<Record> records(entries.size());
+  BlockDeflater deflater(compressionThreads, compressionLevel.value_or(Deflater::defaultLevel));
+  std::deque<Piece> pending;
+  size_t pendingBlocks = 0;
+  // Enough blocks to keep every worker busy, while the oldest block is written
+  const size_t maxPendingBlocks = 2 * deflater.getThreadCount();
+
+  // Write pieces until at most maxBlocks blocks are pending
+  auto writePending = [&](size_t maxBlocks) {
+    while(!pending.empty() && (pending.front().type != Piece::Type::Data || pendingBlocks > maxBlocks)) {
+      if(pending.front().type == Piece::Type::Data) {
+        pendingBlocks--;
+      }
+      if(!writePiece(pending.front(), records, offset, output)) {
+        return false;
+      }
+      pending.pop_front();
+    }
+    return true;
+  };
+
+  // Decides whether members of unknown type are deflated or stored
+  Deflater sampler(sampleLevel);
+
+  for(size_t i = 0; i < entries.size(); i++) {
+    records[i] = createRecord(entries[i]);
+    if(entries[i].directory) {
+      pending.push_back({Piece::Type::LocalHeader, i, {}});
+      continue;
+    }
+
+    File file = openEntry(entries[i]);
+    // The method has to be known, before the local header is added
+    records[i].method = shouldDeflate(file, sampler) ? methodDeflate : methodStore;
+    if(records[i].method == methodStore) {
+      // Streaming unzip implementations cannot find the end of a stored member without its size in the local header, so the checksum
+      // of stored members is computed before they are written
+      records[i].flags = flagUtf8;
+      file.readChunks([&record = records[i]](const char* data, size_t length) {
+        record.crc = crc32(record.crc, data, length);
+        record.uncompressedSize += length;
+        return true;
+      });
+    }
+    pending.push_back({Piece::Type::LocalHeader, i, {}});
+
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    std::string block;
+    auto submitBlock = [&]() {
+      if(records[i].method == methodStore) {
+        std::promise<std::string> stored;
+        stored.set_value(std::move(block));
+        pending.push_back({Piece::Type::Data, i, stored.get_future()});
+      } else {
+        pending.push_back({Piece::Type::Data, i, deflater.compress(std::move(block))});
+      }
+      pendingBlocks++;
+      block.clear();
+      return writePending(maxPendingBlocks);
+    };
+    bool finished = file.readChunks([&](const char* data, size_t length) {
+      crc = crc32(crc, data, length);
+      size += length;
+      while(length > 0) {
+        size_t copied = std::min(BlockDeflater::blockSize - block.size(), length);
+        block.append(data, copied);
+        data += copied;
+        length -= copied;
+        if(block.size() == BlockDeflater::blockSize && !submitBlock()) {
+          return false;
+        }
+      }
+      return true;
+    });
+    if(!finished) {
+      return false;
+    }
+    if(!block.empty() && !submitBlock()) {
+      return false;
+    }
+    if(records[i].method == methodStore) {
+      // The local header was written with the checksum of the first read
+      if(crc != records[i].crc || size != records[i].uncompressedSize) {
+        throw std::runtime_error("Failed to read " + entries[i].path.string() + ". Maybe it was modified while uploading?");
+      }
+    } else {
+      records[i].crc = crc;
+      records[i].uncompressedSize = size;
+      pending.push_back({Piece::Type::DataDescriptor, i, {}});
+    }
+  }
+
+  if(!writePending(0)) {
+    return false;
+  }
+  return writeCentralDirectory(records, offset, output);
+}
+
+ZipArchive::Record ZipArchive::createRecord(const ArchiveEntry& entry) {
+  Record record;
+  record.name = entry.directory ? entry.name + "/" : entry.name;
+  record.zip64 = needsZip64(entry);
+  record.flags = entry.directory ? flagUtf8 : flagUtf8 | flagDataDescriptor;
+  record.method = entry.directory ? methodStore : methodDeflate;
+  record.crc = 0;
+  record.compressedSize = 0;
+  record.uncompressedSize = 0;
+  record.offset = 0;
+  toDosTime(entry.modificationTime, record.time, record.date);
+  uint32_t mode = static_cast<uint32_t>(entry.permissions & std::filesystem::perms::mask);
+  record.externalAttributes = entry.directory ? ((unixDirectoryMode | mode) << 16) | dosDirectoryAttribute : (unixRegularMode | mode) << 16;
+  return record;
+}
+
+bool ZipArchive::writePiece(Piece& piece, std::vector<Record>& records, uint64_t offset, const File::ChunkCallback& output) {
+  Record& record = records[piece.record];
+  switch(piece.type) {
+    case Piece::Type::LocalHeader: {
+      record.offset = offset;
+      std::string header = createLocalHeader(record);
+      return output(header.data(), header.size());
+    }
+    case Piece::Type::Data: {
+      std::string data = piece.data.get();
+      record.compressedSize += data.size();
+      return output(data.data(), data.size());
+    }
+    case Piece::Type::DataDescriptor:
+    default: {
+      // The compressed blocks are not terminated, so the deflate stream is ended before the descriptor
+      if(record.method == methodDeflate) {
+        record.compressedSize += BlockDeflater::finalBlock.size();
+        if(!output(BlockDeflater::finalBlock.data(), BlockDeflater::finalBlock.size())) {
+          return false;
+        }
+      }
+      std::string descriptor = createDataDescriptor(record);
+      return output(descriptor.data(), descriptor.size());
+    }
+  }
+}
+
+std::string ZipArchive::createLocalHeader(const Record& record) {
+  std::string header;
+  append(header, localHeaderSignature);
+  append(header, record.zip64 ? versionZip64 : versionDefault);
+  append(header, record.flags);
+  append(header, record.method);
+  append(header, record.time);
+  append(header, record.date);
+  // Crc and sizes of deflated members are written in the data descriptor. Stored members are as big as their content
+  bool descriptor = record.flags & flagDataDescriptor;
+  uint64_t size = descriptor ? 0 : record.uncompressedSize;
+  append(header, descriptor ? uint32_t(0) : record.crc);
+  append(header, record.zip64 ? max32 : static_cast<uint32_t>(size));
+  append(header, record.zip64 ? max32 : static_cast<uint32_t>(size));
+  append(header, static_cast<uint16_t>(record.name.size()));
+  append(header, static_cast<uint16_t>(record.zip64 ? 20 : 0));
+  header.append(record.name);
+  if(record.zip64) {
+    append(header, zip64ExtraId);
+    append(header, uint16_t(16));
+    append(header, size);
+    append(header, size);
+  }
+  return header;
+}
+
+std::string ZipArchive::createDataDescriptor(const Record& record) {
+  std::string descriptor;
+  append(descriptor, dataDescriptorSignature);
+  append(descriptor, record.crc);
+  if(record.zip64) {
+    append(descriptor, record.compressedSize);
+    append(descriptor, record.uncompressedSize);
+  } else {
+    append(descriptor, static_cast<uint32_t>(record.compressedSize));
+    append(descriptor, static_cast<uint32_t>(record.uncompressedSize));
+  }
+  return descriptor;
+}
+
+bool ZipArchive::writeCentralDirectory(const std::vector<Record>& records, uint64_t offset, const File::ChunkCallback& output) {
+  uint64_t centralDirectoryOffset = offset;
+  uint64_t centralDirectorySize = 0;
+
+  for(const Record& record : records) {
+    bool sizesInExtra = record.zip64;
+    bool offsetInExtra = record.offset >= max32;
+    std::string extra;
+    if(sizesInExtra || offsetInExtra) {
+      append(extra, zip64ExtraId);
+      append(extra, static_cast<uint16_t>((sizesInExtra ? 16 : 0) + (offsetInExtra ? 8 : 0)));
+      if(sizesInExtra) {
+        append(extra, record.uncompressedSize);
+        append(extra, record.compressedSize);
+      }
+      if(offsetInExtra) {
+        append(extra, record.offset);
+      }
+    }
+
+    std::string header;
+    append(header, centralHeaderSignature);
+    append(header, versionMadeBy);
+    append(header, extra.empty() ? versionDefault : versionZip64);
+    append(header, record.flags);
+    append(header, record.method);
+    append(header, record.time);
+    append(header, record.date);
+    append(header, record.crc);
+    append(header, sizesInExtra ? max32 : static_cast<uint32_t>(record.compressedSize));
+    append(header, sizesInExtra ? max32 : static_cast<uint32_t>(record.uncompressedSize));
+    append(header, static_cast<uint16_t>(record.name.size()));
+    append(header, static_cast<uint16_t>(extra.size()));
+    // Comment length, disk number and internal attributes
+    append(header, uint16_t(0));
+    append(header, uint16_t(0));
+    append(header, uint16_t(0));
+    append(header, record.externalAttributes);
+    append(header, offsetInExtra ? max32 : static_cast<uint32_t>(record.offset));
+    header.append(record.name);
+    header.append(extra);
+
+    centralDirectorySize += header.size();
+    if(!output(header.data(), header.size())) {
+      return false;
+    }
+  }
+
+  std::string end;
+  bool zip64End = records.size() >= max16 || centralDirectoryOffset >= max32 || centralDirectorySize >= max32;
+  if(zip64End) {
+    uint64_t zip64EndOffset = centralDirectoryOffset + centralDirectorySize;
+    append(end, zip64EndSignature);
+    // Size of the remaining record
+    append(end, uint64_t(44));
+    append(end, versionMadeBy);
+    append(end, versionZip64);
+    append(end, uint32_t(0));
+    append(end, uint32_t(0));
+    append(end, static_cast<uint64_t>(records.size()));
+    append(end, static_cast<uint64_t>(records.size()));
+    append(end, centralDirectorySize);
+    append(end, centralDirectoryOffset);
+
+    append(end, zip64LocatorSignature);
+    append(end, uint32_t(0));
+    append(end, zip64EndOffset);
+    append(end, uint32_t(1));
+  }
+  append(end, endSignature);
+  append(end, uint16_t(0));
+  append(end, uint16_t(0));
+  append(end, zip64End ? max16 : static_cast<uint16_t>(records.size()));
+  append(end, zip64End ? max16 : static_cast<uint16_t>(records.size()));
+  append(end, zip64End ? max32 : static_cast<uint32_t>(centralDirectorySize));
+  append(end, zip64End ? max32 : static_cast<uint32_t>(centralDirectoryOffset));
+  // Comment length
+  append(end, uint16_t(0));
+  return output(end.data(), end.size());
+}
+
+bool ZipArchive::shouldDeflate(const File& file, Deflater& sampler) {
+  if(isCompressedMimetype(file.getMimetype())) {
+    return false;
+  }
+  // Sampling small members would take about as long as compressing them
+  if(file.getSize() < sampleSize) {
+    return true;
+  }
+  std::string sample(sampleSize, '\0');
+  sample.resize(file.read(0, sample.data(), sample.size()));
+  return isCompressible(sample, sampler);
+}
+
+bool ZipArchive::isCompressible(std::string_view sample, Deflater& sampler) {
+  size_t compressedSize = 0;
+  File::ChunkCallback count = [&compressedSize](const char*, size_t length) {
+    compressedSize += length;
+    return true;
+  };
+  sampler.reset();
+  sampler.compress(sample.data(), sample.size(), count);
+  sampler.finish(count);
+  return compressedSize < sample.size() - sample.size() / minimumSavings;
+}
+
+bool ZipArchive::isCompressedMimetype(const std::string& mimetype) {
+  static const std::set<std::string> compressedMimetypes = {"application/gzip",
+                                                            "application/java-archive",
+                                                            "application/vnd.android.package-archive",
+                                                            "application/x-7z-compressed",
+                                                            "application/x-bzip2",
+                                                            "application/x-xz",
+                                                            "application/zip",
+                                                            "application/zstd",
+                                                            "audio/mp3",
+                                                            "audio/mpeg",
+                                                            "audio/webm",
+                                                            "font/woff",
+                                                            "font/woff2",
+                                                            "image/apng",
+                                                            "image/avif",
+                                                            "image/gif",
+                                                            "image/jpeg",
+                                                            "image/png",
+                                                            "image/webp",
+                                                            "video/mp4",
+                                                            "video/mpeg",
+                                                            "video/webm"};
+  return compressedMimetypes.contains(mimetype);
+}
+
+bool ZipArchive::needsZip64(const ArchiveEntry& entry) {
+  return entry.size >= zip64Threshold;
+}
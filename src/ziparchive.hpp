@@ -0,0 +1,75 @@
+#ifndef ZIP_ARCHIVE_HPP
+#define ZIP_ARCHIVE_HPP
+
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archive.hpp"
+#include "compressor.hpp"
+
+// Generates a zip archive. Each member is compressed while it is read. Sizes and checksums of deflated members follow the data in data
+// descriptors, so nothing has to be known before they are written. Zip64 records are used for big members and archives.
+// Blocks of the members are compressed in parallel and written in their original order. Members that are compressed already
+// are stored instead. Stored members are read twice, so their checksum and size are in the local header like streaming unzip
+// implementations expect.
+class ZipArchive: public ArchiveSource {
+  // Everything the central directory needs to know about a written member
+  struct Record {
+    std::string name;
+    uint16_t flags;
+    uint16_t method;
+    uint16_t time;
+    uint16_t date;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t offset;
+    uint32_t externalAttributes;
+    bool zip64;
+  };
+
+  // A part of the archive, that is written after all parts before it are written
+  struct Piece {
+    enum class Type { LocalHeader, Data, DataDescriptor };
+    Type type;
+    size_t record;
+    // Compressed data of a block. Only used for Data
+    std::future<std::string> data;
+  };
+
+  // Uses one thread per core, if this is 0
+  unsigned int compressionThreads;
+  // Uses the default deflate level, if not set
+  std::optional<int> compressionLevel;
+
+ public:
+  ZipArchive(std::vector<ArchiveEntry> entries,
+             size_t bufferSize,
+             bool memoryMap,
+             unsigned int compressionThreads = 0,
+             std::optional<int> compressionLevel = std::nullopt);
+  [[nodiscard]] size_t getSize() const override;
+
+ protected:
+  bool write(const File::ChunkCallback& callback) override;
+
+ private:
+  static Record createRecord(const ArchiveEntry& entry);
+  // Write piece and update its record. Throws std::runtime_error, if compressing failed
+  static bool writePiece(Piece& piece, std::vector<Record>& records, uint64_t offset, const File::ChunkCallback& output);
+  static std::string createLocalHeader(const Record& record);
+  static std::string createDataDescriptor(const Record& record);
+  static bool writeCentralDirectory(const std::vector<Record>& records, uint64_t offset, const File::ChunkCallback& output);
+  // Decide from the mimetype and a sample of the content, whether a member is deflated or stored
+  static bool shouldDeflate(const File& file, Deflater& sampler);
+  // Check whether deflating sample saves enough space to be worth it
+  static bool isCompressible(std::string_view sample, Deflater& sampler);
+  static bool isCompressedMimetype(const std::string& mimetype);
+  static bool needsZip64(const ArchiveEntry& entry);
+};
+
+#endif